@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "../src/types.hpp"
+#include "../src/timer.hpp"
+
+/**
+ * Small benchmark harness shared by the benchmark executables.
+ *
+ * A benchmark is a function that runs one pass over a fixed set of inputs and
+ * returns a checksum (so the work can't be optimized away). The harness warms
+ * up, sizes a sample to take about benchmark_sample_ns, then times
+ * benchmark_sample_count samples and reports the median and interquartile range.
+ * The median and IQR are used instead of the mean so a context switch in one
+ * sample doesn't skew the result.
+ */
+
+const int32  benchmark_sample_count = 31;
+const uint64 benchmark_sample_ns    = 5000000;  // 5 ms
+const uint64 benchmark_warmup_ns    = 50000000; // 50 ms
+
+struct BenchmarkResult {
+	std::string name;
+	std::string distribution;
+	int64       items_per_pass;
+	int64       passes_per_sample;
+	float64     median_ns; // Per item
+	float64     q1_ns;
+	float64     q3_ns;
+	float64     items_per_second;
+	float64     hit_rate; // Fraction of items the pass counted (ex. hits), shows the inputs are what they say
+};
+
+// Checksum sink so the optimizer keeps every call
+volatile uint64 benchmark_sink = 0;
+
+/**
+ * Time a benchmark
+ * @param pass Runs every item once and returns the number of items that hit (or another count worth checking)
+ */
+template<typename Pass>
+BenchmarkResult run_benchmark(const char* name, const char* distribution, int64 item_count, Pass pass) {
+	// Warm up caches, branch predictors and CPU clocks, and find how many passes fill a sample
+	int64 passes = 0;
+	uint64 hits = 0;
+	uint64 warmup_start = timer_nanoseconds();
+	uint64 warmup_time = 0;
+	while (warmup_time < benchmark_warmup_ns) {
+		hits += pass();
+		passes++;
+		warmup_time = timer_nanoseconds() - warmup_start;
+	}
+
+	int64 passes_per_sample = (int64)(benchmark_sample_ns * passes / warmup_time);
+	if (passes_per_sample < 1) {
+		passes_per_sample = 1;
+	}
+
+	std::vector<float64> samples;
+	for (int32 i = 0; i < benchmark_sample_count; i++) {
+		uint64 start = timer_nanoseconds();
+		for (int64 j = 0; j < passes_per_sample; j++) {
+			hits += pass();
+		}
+		uint64 end = timer_nanoseconds();
+		samples.push_back((float64)(end - start) / (float64)(passes_per_sample * item_count));
+	}
+	benchmark_sink = benchmark_sink + hits;
+
+	std::sort(samples.begin(), samples.end());
+
+	BenchmarkResult result;
+	result.name = name;
+	result.distribution = distribution;
+	result.items_per_pass = item_count;
+	result.passes_per_sample = passes_per_sample;
+	result.median_ns = samples[samples.size() / 2];
+	result.q1_ns = samples[samples.size() / 4];
+	result.q3_ns = samples[(samples.size() * 3) / 4];
+	result.items_per_second = 1e9 / result.median_ns;
+	result.hit_rate = (float64)pass() / (float64)item_count;
+	return result;
+}
+
+/**
+ * @param count_name What the pass counts (see BenchmarkResult::hit_rate)
+ */
+void print_benchmark_result(const BenchmarkResult* result, const char* count_name = "hits") {
+	char line[256];
+	snprintf(line, sizeof(line), "%-52s %-16s %9.2f ns  IQR %7.2f ns  %12.0f /s  %s %5.1f%%",
+			result->name.c_str(), result->distribution.c_str(), result->median_ns,
+			result->q3_ns - result->q1_ns, result->items_per_second, count_name, result->hit_rate * 100.0);
+	std::cout << line << std::endl;
+}
+
+/**
+ * Write results as JSON for tracking them across builds
+ * @returns False if the file couldn't be written
+ */
+bool write_benchmark_json(const char* path, const char* suite, const std::vector<BenchmarkResult>& results) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		std::cout << "Failed to open benchmark output: " << path << std::endl;
+		return false;
+	}
+
+	fprintf(file, "{\n  \"suite\": \"%s\",\n  \"samples\": %d,\n  \"benchmarks\": [\n", suite, benchmark_sample_count);
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult* result = &results[i];
+		fprintf(file, "    {\"name\": \"%s\", \"distribution\": \"%s\", \"median_ns\": %.4f, \"q1_ns\": %.4f, \"q3_ns\": %.4f, "
+				"\"iqr_ns\": %.4f, \"per_second\": %.1f, \"hit_rate\": %.4f, \"items_per_sample\": %lld}%s\n",
+				result->name.c_str(), result->distribution.c_str(), result->median_ns, result->q1_ns, result->q3_ns,
+				result->q3_ns - result->q1_ns, result->items_per_second, result->hit_rate,
+				(long long)(result->items_per_pass * result->passes_per_sample), i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+//
+// Baselines
+//
+// A baseline is a text file with a "name distribution median_ns" line per benchmark,
+// saved from a known good build on the machine that runs the comparison.
+//
+
+/**
+ * @returns False if the file couldn't be written
+ */
+bool write_benchmark_baseline(const char* path, const std::vector<BenchmarkResult>& results) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		std::cout << "Failed to open baseline file: " << path << std::endl;
+		return false;
+	}
+
+	for (const BenchmarkResult& result : results) {
+		fprintf(file, "%s %s %.4f\n", result.name.c_str(), result.distribution.c_str(), result.median_ns);
+	}
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+/**
+ * Compare results to a baseline and print how much each one changed
+ * @param threshold Fraction slower than the baseline that counts as a regression (ex. 0.1 for 10%)
+ * @returns False if any benchmark regressed or the baseline couldn't be read
+ */
+bool check_benchmark_baseline(const char* path, const std::vector<BenchmarkResult>& results, float64 threshold) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		std::cout << "Failed to open baseline file: " << path << std::endl;
+		return false;
+	}
+
+	bool passed = true;
+	char name[128], distribution[64];
+	double baseline_ns;
+	while (fscanf(file, "%127s %63s %lf", name, distribution, &baseline_ns) == 3) {
+		const BenchmarkResult* match = NULL;
+		for (const BenchmarkResult& result : results) {
+			if (result.name == name && result.distribution == distribution) {
+				match = &result;
+			}
+		}
+
+		if (match == NULL) {
+			std::cout << "Baseline benchmark was not run: " << name << " " << distribution << std::endl;
+			continue;
+		}
+
+		float64 change = match->median_ns / baseline_ns - 1.0;
+		bool regressed = change > threshold;
+		passed &= !regressed;
+
+		char line[256];
+		snprintf(line, sizeof(line), "%-52s %-16s %9.2f ns -> %9.2f ns  %+6.1f%%%s",
+				name, distribution, baseline_ns, match->median_ns, change * 100.0, regressed ? "  REGRESSED" : "");
+		std::cout << line << std::endl;
+	}
+	fclose(file);
+
+	return passed;
+}
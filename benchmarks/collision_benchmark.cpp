@@ -0,0 +1,335 @@
+#include <iostream>
+#include <random>
+#include <string.h>
+#include <vector>
+#include "benchmark.hpp"
+#include "../src/collision.hpp"
+
+/**
+ * Micro benchmarks for every function in raycast.hpp and collision.hpp.
+ *
+ * Each function is timed over several input distributions (hits, misses, grazing
+ * and corner hits) since the early outs make the cost depend heavily on the input.
+ * The shapes and motion lengths match the game (ball radius 0.2, tile 1 x 0.5).
+ *
+ * Arguments:
+ * - --json <path>: Also write the results as JSON
+ * - --filter <text>: Only run benchmarks whose name contains text
+ */
+
+const int32   benchmark_item_count = 4096;
+const float32 ball_radius          = 0.2f;
+const Vec2    rectangle_size       = Vec2(1.0f, 0.5f);
+const Vec2    origin               = Vec2(0.0f, 0.0f);
+
+struct RayCase {
+	Vec2 pos;
+	Vec2 dir;
+};
+
+struct MoveCase {
+	Vec2 p1;
+	Vec2 p2;
+};
+
+std::mt19937 rng(1234);
+
+float32 random_range(float32 min, float32 max) {
+	return std::uniform_real_distribution<float32>(min, max)(rng);
+}
+
+float32 random_sign() {
+	return (rng() & 1) ? 1.0f : -1.0f;
+}
+
+Vec2 swap_axes(Vec2 v) {
+	return Vec2(v.y, v.x);
+}
+
+//
+// Input distributions
+//
+
+/**
+ * Ray towards a unit circle at the origin that passes offset units from its center
+ */
+RayCase ray_at_circle(float32 offset) {
+	float32 angle = random_range(0.0f, 2.0f * 3.14159f);
+	Vec2 dir = Vec2(-cos(angle), -sin(angle));
+	Vec2 perpendicular = Vec2(-dir.y, dir.x);
+
+	RayCase ray;
+	ray.pos = Vec2(cos(angle), sin(angle)) * random_range(3.0f, 8.0f) + perpendicular * offset;
+	ray.dir = dir;
+	return ray;
+}
+
+/**
+ * Ray towards the horizontal line y = 0 that crosses it at target_x
+ * @param min_angle Min angle from the line in radians
+ * @param max_angle Max angle from the line in radians, small angles graze the line
+ */
+RayCase ray_at_horizontal_line(float32 target_x, float32 min_angle, float32 max_angle) {
+	float32 angle = random_range(min_angle, max_angle);
+	float32 side = random_sign();
+	Vec2 dir = Vec2(cos(angle) * random_sign(), -side * sin(angle));
+
+	RayCase ray;
+	ray.pos = Vec2(target_x, 0.0f) - dir * random_range(0.5f, 5.0f);
+	ray.dir = dir;
+	return ray;
+}
+
+RayCase ray_away_from_horizontal_line() {
+	RayCase ray = ray_at_horizontal_line(random_range(-2.0f, 2.0f), 0.2f, 1.5f);
+	ray.dir = ray.dir * -1.0f;
+	return ray;
+}
+
+/**
+ * Circle moving across the vertical line x = 0
+ * @param end_gap Distance past the radius where the motion ends, negative crosses the line
+ */
+MoveCase move_at_vertical_line(float32 end_gap) {
+	float32 side = random_sign();
+	MoveCase move;
+	move.p2 = Vec2(side * (ball_radius + end_gap), random_range(-4.0f, 4.0f));
+	move.p1 = move.p2 + Vec2(side * random_range(0.15f, 0.3f), random_range(-0.2f, 0.2f));
+	return move;
+}
+
+enum RectangleCase {
+	RECTANGLE_FAR_MISS,   // Rejected by the quick check
+	RECTANGLE_NEAR_MISS,  // Passes the quick check but misses
+	RECTANGLE_SIDE_HIT,
+	RECTANGLE_CORNER_HIT,
+	RECTANGLE_GRAZING     // Passes within 1% of the radius from a corner
+};
+
+/**
+ * Circle moving about one frame's distance near a rectangle at the origin
+ */
+MoveCase move_near_rectangle(RectangleCase type) {
+	Vec2 extent = rectangle_size * 0.5f + Vec2_ONE * ball_radius;
+	while (true) {
+		MoveCase move;
+		float32 angle = random_range(0.0f, 2.0f * 3.14159f);
+		Vec2 delta = Vec2(cos(angle), sin(angle)) * random_range(0.05f, 0.3f);
+
+		if (type == RECTANGLE_FAR_MISS) {
+			// Anywhere in the world, like most tiles each frame
+			move.p1 = Vec2(random_range(-8.0f, 8.0f), random_range(-4.5f, 4.5f));
+			move.p2 = move.p1 + delta;
+			if (!moving_circle_to_retangle_collision_quick_check(move.p1, move.p2, ball_radius, origin, rectangle_size)) {
+				return move;
+			}
+			continue;
+		}
+
+		if (type == RECTANGLE_GRAZING) {
+			// Moving parallel to a side, just above or below the corner's radius
+			Vec2 corner = Vec2(rectangle_size.x * 0.5f * random_sign(), rectangle_size.y * 0.5f * random_sign());
+			float32 offset = ball_radius * random_range(0.99f, 1.01f);
+			float32 direction = random_sign();
+			move.p1 = Vec2(corner.x - direction * 0.15f, corner.y + (corner.y > 0.0f ? offset : -offset));
+			move.p2 = move.p1 + Vec2(direction * 0.3f, 0.0f);
+			return move;
+		}
+
+		move.p1 = Vec2(random_range(-extent.x - 0.3f, extent.x + 0.3f), random_range(-extent.y - 0.3f, extent.y + 0.3f));
+		move.p2 = move.p1 + delta;
+		if (!moving_circle_to_retangle_collision_quick_check(move.p1, move.p2, ball_radius, origin, rectangle_size)) {
+			continue;
+		}
+
+		float32 distance;
+		Vec2 point, normal;
+		bool hit = moving_circle_to_retangle_collision_narrow_check(move.p1, move.p2, ball_radius, origin, rectangle_size,
+				&distance, &point, &normal);
+		bool corner_hit = hit && fabs(normal.x) > 0.001f && fabs(normal.y) > 0.001f;
+
+		if ((type == RECTANGLE_NEAR_MISS && !hit)
+				|| (type == RECTANGLE_SIDE_HIT && hit && !corner_hit)
+				|| (type == RECTANGLE_CORNER_HIT && corner_hit))
+		{
+			return move;
+		}
+	}
+}
+
+template<typename Generate>
+std::vector<RayCase> make_rays(Generate generate) {
+	std::vector<RayCase> rays;
+	for (int32 i = 0; i < benchmark_item_count; i++) {
+		rays.push_back(generate());
+	}
+	return rays;
+}
+
+template<typename Generate>
+std::vector<MoveCase> make_moves(Generate generate) {
+	std::vector<MoveCase> moves;
+	for (int32 i = 0; i < benchmark_item_count; i++) {
+		moves.push_back(generate());
+	}
+	return moves;
+}
+
+//
+// Benchmarks
+//
+
+std::vector<BenchmarkResult> results;
+const char* name_filter = NULL;
+
+template<typename Pass>
+void add_benchmark(const char* name, const char* distribution, Pass pass) {
+	if (name_filter != NULL && strstr(name, name_filter) == NULL) {
+		return;
+	}
+	results.push_back(run_benchmark(name, distribution, benchmark_item_count, pass));
+	print_benchmark_result(&results.back());
+}
+
+/**
+ * Time a ray function over a set of rays, call(ray, distance, point, normal) runs the function
+ */
+template<typename Call>
+void add_ray_benchmark(const char* name, const char* distribution, std::vector<RayCase> rays, Call call) {
+	add_benchmark(name, distribution, [rays, call]() {
+		uint64 hits = 0;
+		float32 distance;
+		Vec2 point, normal;
+		for (const RayCase& ray : rays) {
+			hits += call(ray, &distance, &point, &normal);
+		}
+		return hits;
+	});
+}
+
+template<typename Call>
+void add_move_benchmark(const char* name, const char* distribution, std::vector<MoveCase> moves, Call call) {
+	add_benchmark(name, distribution, [moves, call]() {
+		uint64 hits = 0;
+		float32 distance;
+		Vec2 point, normal;
+		for (const MoveCase& move : moves) {
+			hits += call(move, &distance, &point, &normal);
+		}
+		return hits;
+	});
+}
+
+void run_raycast_benchmarks() {
+	auto circle = [](const RayCase& ray, float32* distance, Vec2* point, Vec2* normal) {
+		return raycast_circle(ray.pos, ray.dir, origin, 1.0f, distance, point, normal);
+	};
+	add_ray_benchmark("raycast_circle", "hit", make_rays([]() { return ray_at_circle(random_range(-0.9f, 0.9f)); }), circle);
+	add_ray_benchmark("raycast_circle", "miss", make_rays([]() { return ray_at_circle(random_sign() * random_range(1.1f, 3.0f)); }), circle);
+	add_ray_benchmark("raycast_circle", "grazing", make_rays([]() { return ray_at_circle(random_sign() * random_range(0.99f, 1.01f)); }), circle);
+
+	auto horizontal = [](const RayCase& ray, float32* distance, Vec2* point, Vec2* normal) {
+		return raycast_horizontal_line(ray.pos, ray.dir, 0.0f, distance, point, normal);
+	};
+	auto vertical = [](const RayCase& ray, float32* distance, Vec2* point, Vec2* normal) {
+		return raycast_vertical_line(swap_axes(ray.pos), swap_axes(ray.dir), 0.0f, distance, point, normal);
+	};
+	auto horizontal_segment = [](const RayCase& ray, float32* distance, Vec2* point, Vec2* normal) {
+		return raycast_horizontal_line_segment(ray.pos, ray.dir, 0.0f, -1.0f, 1.0f, distance, point, normal);
+	};
+	auto vertical_segment = [](const RayCase& ray, float32* distance, Vec2* point, Vec2* normal) {
+		return raycast_vertical_line_segment(swap_axes(ray.pos), swap_axes(ray.dir), 0.0f, -1.0f, 1.0f, distance, point, normal);
+	};
+
+	// Vertical rays are the horizontal cases with x and y swapped
+	std::vector<RayCase> line_hits = make_rays([]() { return ray_at_horizontal_line(random_range(-2.0f, 2.0f), 0.2f, 1.5f); });
+	std::vector<RayCase> line_misses = make_rays([]() { return ray_away_from_horizontal_line(); });
+	std::vector<RayCase> line_grazing = make_rays([]() { return ray_at_horizontal_line(random_range(-2.0f, 2.0f), 0.0001f, 0.01f); });
+	std::vector<RayCase> segment_hits = make_rays([]() { return ray_at_horizontal_line(random_range(-0.9f, 0.9f), 0.2f, 1.5f); });
+	std::vector<RayCase> segment_misses = make_rays([]() { return ray_at_horizontal_line(random_sign() * random_range(1.1f, 4.0f), 0.2f, 1.5f); });
+	std::vector<RayCase> segment_grazing = make_rays([]() { return ray_at_horizontal_line(random_sign() * random_range(0.99f, 1.01f), 0.2f, 1.5f); });
+
+	add_ray_benchmark("raycast_horizontal_line", "hit", line_hits, horizontal);
+	add_ray_benchmark("raycast_horizontal_line", "miss", line_misses, horizontal);
+	add_ray_benchmark("raycast_horizontal_line", "grazing", line_grazing, horizontal);
+	add_ray_benchmark("raycast_horizontal_line_segment", "hit", segment_hits, horizontal_segment);
+	add_ray_benchmark("raycast_horizontal_line_segment", "miss", segment_misses, horizontal_segment);
+	add_ray_benchmark("raycast_horizontal_line_segment", "grazing", segment_grazing, horizontal_segment);
+	add_ray_benchmark("raycast_vertical_line", "hit", line_hits, vertical);
+	add_ray_benchmark("raycast_vertical_line", "miss", line_misses, vertical);
+	add_ray_benchmark("raycast_vertical_line", "grazing", line_grazing, vertical);
+	add_ray_benchmark("raycast_vertical_line_segment", "hit", segment_hits, vertical_segment);
+	add_ray_benchmark("raycast_vertical_line_segment", "miss", segment_misses, vertical_segment);
+	add_ray_benchmark("raycast_vertical_line_segment", "grazing", segment_grazing, vertical_segment);
+}
+
+void run_collision_benchmarks() {
+	auto vertical_line = [](const MoveCase& move, float32* distance, Vec2* point, Vec2* normal) {
+		return moving_circle_to_vertical_line_collision_check(move.p1, move.p2, ball_radius, 0.0f, distance, point, normal);
+	};
+	auto horizontal_line = [](const MoveCase& move, float32* distance, Vec2* point, Vec2* normal) {
+		return moving_circle_to_horizontal_line_collision_check(swap_axes(move.p1), swap_axes(move.p2), ball_radius, 0.0f, distance, point, normal);
+	};
+
+	std::vector<MoveCase> line_hits = make_moves([]() { return move_at_vertical_line(-random_range(0.01f, 0.1f)); });
+	std::vector<MoveCase> line_misses = make_moves([]() { return move_at_vertical_line(random_range(0.05f, 3.0f)); });
+	std::vector<MoveCase> line_grazing = make_moves([]() { return move_at_vertical_line(random_range(-0.001f, 0.001f)); });
+
+	add_move_benchmark("moving_circle_to_vertical_line_collision_check", "hit", line_hits, vertical_line);
+	add_move_benchmark("moving_circle_to_vertical_line_collision_check", "miss", line_misses, vertical_line);
+	add_move_benchmark("moving_circle_to_vertical_line_collision_check", "grazing", line_grazing, vertical_line);
+	add_move_benchmark("moving_circle_to_horizontal_line_collision_check", "hit", line_hits, horizontal_line);
+	add_move_benchmark("moving_circle_to_horizontal_line_collision_check", "miss", line_misses, horizontal_line);
+	add_move_benchmark("moving_circle_to_horizontal_line_collision_check", "grazing", line_grazing, horizontal_line);
+
+	auto quick = [](const MoveCase& move, float32* distance, Vec2* point, Vec2* normal) {
+		return moving_circle_to_retangle_collision_quick_check(move.p1, move.p2, ball_radius, origin, rectangle_size);
+	};
+	auto narrow = [](const MoveCase& move, float32* distance, Vec2* point, Vec2* normal) {
+		return moving_circle_to_retangle_collision_narrow_check(move.p1, move.p2, ball_radius, origin, rectangle_size, distance, point, normal);
+	};
+	auto full = [](const MoveCase& move, float32* distance, Vec2* point, Vec2* normal) {
+		return moving_circle_to_retangle_collision_check(move.p1, move.p2, ball_radius, origin, rectangle_size, distance, point, normal);
+	};
+
+	std::vector<MoveCase> far_misses = make_moves([]() { return move_near_rectangle(RECTANGLE_FAR_MISS); });
+	std::vector<MoveCase> near_misses = make_moves([]() { return move_near_rectangle(RECTANGLE_NEAR_MISS); });
+	std::vector<MoveCase> side_hits = make_moves([]() { return move_near_rectangle(RECTANGLE_SIDE_HIT); });
+	std::vector<MoveCase> corner_hits = make_moves([]() { return move_near_rectangle(RECTANGLE_CORNER_HIT); });
+	std::vector<MoveCase> grazing = make_moves([]() { return move_near_rectangle(RECTANGLE_GRAZING); });
+
+	add_move_benchmark("moving_circle_to_retangle_collision_quick_check", "far_miss", far_misses, quick);
+	add_move_benchmark("moving_circle_to_retangle_collision_quick_check", "near", near_misses, quick);
+	add_move_benchmark("moving_circle_to_retangle_collision_narrow_check", "near_miss", near_misses, narrow);
+	add_move_benchmark("moving_circle_to_retangle_collision_narrow_check", "side_hit", side_hits, narrow);
+	add_move_benchmark("moving_circle_to_retangle_collision_narrow_check", "corner_hit", corner_hits, narrow);
+	add_move_benchmark("moving_circle_to_retangle_collision_narrow_check", "grazing", grazing, narrow);
+	add_move_benchmark("moving_circle_to_retangle_collision_check", "far_miss", far_misses, full);
+	add_move_benchmark("moving_circle_to_retangle_collision_check", "near_miss", near_misses, full);
+	add_move_benchmark("moving_circle_to_retangle_collision_check", "side_hit", side_hits, full);
+	add_move_benchmark("moving_circle_to_retangle_collision_check", "corner_hit", corner_hits, full);
+	add_move_benchmark("moving_circle_to_retangle_collision_check", "grazing", grazing, full);
+}
+
+int main(int argc, char** argv) {
+	const char* json_path = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			json_path = argv[++i];
+		} else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			name_filter = argv[++i];
+		}
+	}
+
+	std::cout << std::endl << "Running Collision Benchmarks..." << std::endl << std::endl;
+	run_raycast_benchmarks();
+	run_collision_benchmarks();
+
+	if (json_path != NULL) {
+		if (!write_benchmark_json(json_path, "collision", results)) {
+			return 1;
+		}
+		std::cout << std::endl << "Wrote results to " << json_path << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "benchmark.hpp"
+#include "../src/game.hpp"
+
+/**
+ * End to end benchmark of Game::update() over scripted games.
+ *
+ * Each scenario plays games with a paddle that follows the ball and presses start
+ * whenever the game waits for it, and is timed per simulated frame. Results can
+ * be saved as a baseline and later runs compared against it, failing if any
+ * scenario got slower than the threshold.
+ *
+ * Arguments:
+ * - --json <path>: Also write the results as JSON
+ * - --save-baseline <path>: Write the results as the new baseline
+ * - --baseline <path>: Compare against a baseline, exit code 1 on a regression
+ * - --threshold <percent>: How much slower than the baseline counts as a regression (default 10)
+ */
+
+const int32   frames_per_pass  = 1000;
+const float64 frame_time       = 1.0 / 60.0;
+const int32   batch_game_count = 256;
+const float32 follow_dead_zone = 0.3f; // Paddle stays still when the ball is this close to its center
+
+const Vec2Int default_grid_size = Vec2Int(Game::default_grid_size_x, Game::default_grid_size_y);
+const Vec2Int wide_grid_size    = Vec2Int(24, 6); // Not the default, so it runs the tile loops sized at runtime
+
+/**
+ * Scripted player for a single game
+ */
+struct ScriptedGame {
+	Game::Data* data;
+	Game::Input input;
+};
+
+ScriptedGame create_scripted_game(int32 level) {
+	ScriptedGame game;
+	game.data = Game::init_headless(default_grid_size);
+	Game::start_level(game.data, level);
+	game.input = {};
+	game.input.delta_time = frame_time;
+	return game;
+}
+
+/**
+ * Play frames_per_pass frames
+ * @returns Frames where the game was playing
+ */
+uint64 play_scripted_game(ScriptedGame* game) {
+	uint64 playing_frames = 0;
+	Game::Observation observation;
+	for (int32 i = 0; i < frames_per_pass; i++) {
+		Game::observe(game->data, &observation);
+		bool playing = observation.state == 1;
+		playing_frames += playing;
+
+		float32 offset = observation.ball_pos.x - observation.paddle_pos_x;
+		game->input.left_key_pressed = offset < -follow_dead_zone;
+		game->input.right_key_pressed = offset > follow_dead_zone;
+		game->input.start_key_pressed_prev = game->input.start_key_pressed;
+		game->input.start_key_pressed = !playing && !game->input.start_key_pressed_prev;
+		game->input.frame_time += frame_time;
+
+		Game::update(&game->input, game->data);
+	}
+	return playing_frames;
+}
+
+/**
+ * Scripted player for a batch of games stepped with step_batch() or step_lanes()
+ */
+struct ScriptedBatch {
+	Game::Data*      games;
+	Game::LaneBatch* lanes;
+	int32            observation_size;
+	float32*         observations;
+	float32*         rewards;
+	uint8*           dones;
+	uint8*           actions;
+};
+
+ScriptedBatch create_scripted_batch(bool use_lanes, Vec2Int grid_size) {
+	ScriptedBatch batch;
+	batch.observation_size = Game::batch_observation_size(grid_size);
+	batch.observations = new float32[batch_game_count * batch.observation_size];
+	batch.rewards = new float32[batch_game_count];
+	batch.dones = new uint8[batch_game_count];
+	batch.actions = new uint8[batch_game_count];
+	batch.games = NULL;
+	batch.lanes = NULL;
+
+	if (use_lanes) {
+		batch.lanes = Game::init_lanes(batch_game_count, 1, grid_size);
+		Game::reset_lanes(batch.lanes, batch.observations);
+	} else {
+		batch.games = Game::init_batch(batch_game_count, 1, grid_size);
+		Game::reset_batch(batch.games, batch_game_count, batch.observations);
+	}
+	return batch;
+}
+
+/**
+ * Step every game frames_per_pass times
+ * @returns Game frames that didn't end a game
+ */
+uint64 play_scripted_batch(ScriptedBatch* batch) {
+	uint64 playing_frames = 0;
+	for (int32 i = 0; i < frames_per_pass; i++) {
+		for (int32 j = 0; j < batch_game_count; j++) {
+			const float32* observation = batch->observations + j * batch->observation_size;
+			float32 offset = observation[1] - observation[0];
+			batch->actions[j] = offset < -follow_dead_zone ? 1 : (offset > follow_dead_zone ? 2 : 0);
+		}
+
+		if (batch->lanes != NULL) {
+			Game::step_lanes(batch->lanes, frame_time, batch->actions, batch->observations, batch->rewards, batch->dones);
+		} else {
+			Game::step_batch(batch->games, batch_game_count, frame_time, batch->actions, batch->observations, batch->rewards, batch->dones);
+		}
+
+		for (int32 j = 0; j < batch_game_count; j++) {
+			playing_frames += batch->dones[j] == 0;
+		}
+	}
+	return playing_frames;
+}
+
+std::vector<BenchmarkResult> results;
+
+template<typename Pass>
+void add_scenario(const char* name, int64 frames_per_pass, Pass pass) {
+	results.push_back(run_benchmark("game_update", name, frames_per_pass, pass));
+	print_benchmark_result(&results.back(), "playing");
+}
+
+int main(int argc, char** argv) {
+	const char* json_path = NULL;
+	const char* save_baseline_path = NULL;
+	const char* baseline_path = NULL;
+	float64 threshold_percent = 10.0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			json_path = argv[++i];
+		} else if (strcmp(argv[i], "--save-baseline") == 0 && i + 1 < argc) {
+			save_baseline_path = argv[++i];
+		} else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+			baseline_path = argv[++i];
+		} else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+			threshold_percent = atof(argv[++i]);
+		}
+	}
+
+	std::cout << std::endl << "Running Game Benchmarks..." << std::endl << std::endl;
+
+	//
+	// Scenarios
+	//
+	ScriptedGame default_game = create_scripted_game(1);
+	add_scenario("default", frames_per_pass, [&]() { return play_scripted_game(&default_game); });
+
+	// Fast ball and tiles that take many hits, so the ball spends most frames bouncing in the tiles
+	ScriptedGame high_level_game = create_scripted_game(10);
+	add_scenario("high_level", frames_per_pass, [&]() { return play_scripted_game(&high_level_game); });
+
+	// Many balls at once, one per game in a batch
+	ScriptedBatch batch = create_scripted_batch(false, default_grid_size);
+	add_scenario("many_balls", frames_per_pass * batch_game_count, [&]() { return play_scripted_batch(&batch); });
+
+	ScriptedBatch lanes = create_scripted_batch(true, default_grid_size);
+	add_scenario("many_balls_lanes", frames_per_pass * batch_game_count, [&]() { return play_scripted_batch(&lanes); });
+
+	// Four times the tiles of the default grid
+	ScriptedBatch wide_batch = create_scripted_batch(false, wide_grid_size);
+	add_scenario("wide_grid", frames_per_pass * batch_game_count, [&]() { return play_scripted_batch(&wide_batch); });
+
+	ScriptedBatch wide_lanes = create_scripted_batch(true, wide_grid_size);
+	add_scenario("wide_grid_lanes", frames_per_pass * batch_game_count, [&]() { return play_scripted_batch(&wide_lanes); });
+
+	//
+	// Output
+	//
+	std::cout << std::endl;
+	if (json_path != NULL && write_benchmark_json(json_path, "game", results)) {
+		std::cout << "Wrote results to " << json_path << std::endl;
+	}
+
+	if (save_baseline_path != NULL && write_benchmark_baseline(save_baseline_path, results)) {
+		std::cout << "Saved baseline to " << save_baseline_path << std::endl;
+	}
+
+	if (baseline_path != NULL) {
+		std::cout << "Comparing to baseline " << baseline_path << " (threshold " << threshold_percent << "%)" << std::endl;
+		if (!check_benchmark_baseline(baseline_path, results, threshold_percent / 100.0)) {
+			std::cout << "Performance regressed." << std::endl;
+			return 1;
+		}
+		std::cout << "No regressions." << std::endl;
+	}
+	return 0;
+}
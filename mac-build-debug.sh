@@ -6,7 +6,7 @@ rm -r bin/mac-debug
 mkdir -p bin/mac-debug
 
 # Compile tests
-g++ -o bin/mac-debug/BreakoutCppMac_tests.app tests/*.cpp -DMACOS -Wall -O0 -g
+g++ -o bin/mac-debug/BreakoutCppMac_tests.app tests/*.cpp src/game.cpp src/lanes.cpp src/metrics.cpp third-party/src/*.c -DMACOS -Ithird-party/include -std=c++17 -Wall -O0 -g
 
 # Run tests
 ./bin/mac-debug/BreakoutCppMac_tests.app
@@ -15,7 +15,8 @@ g++ -o bin/mac-debug/BreakoutCppMac_tests.app tests/*.cpp -DMACOS -Wall -O0 -g
 version=$(cat version.txt)
 
 # Compile @todo: compile .c files with gcc
-g++ -o bin/mac-debug/BreakoutCppMac_debug.app src/*.cpp third-party/src/*.c -DMACOS -DVERSION=\"$version-debug\" -Ithird-party/include -Lthird-party/lib-mac -lglfw3 -framework Cocoa -framework OpenGL -framework IOKit -Wall -O0 -g
+g++ -o bin/mac-debug/BreakoutCppMac_debug.app src/*.cpp third-party/src/*.c -DMACOS -DPROFILER -DALLOC_TRACKING -DVERSION=\"$version-debug\" -Ithird-party/include -Lthird-party/lib-mac -lglfw3 -framework Cocoa -framework OpenGL -framework IOKit -std=c++17 -Wall -O0 -g
 
-# Copy shaders to bin/mac-debug
-cp -r assets/shaders bin/mac-debug/shaders
+# Pack assets into bin/mac-debug/assets.pack
+g++ -o bin/mac-debug/asset_packer tools/asset_packer.cpp -DMACOS -std=c++17 -Wall -O2
+./bin/mac-debug/asset_packer assets bin/mac-debug/assets.pack
@@ -7,8 +7,21 @@ version=$(cat version.txt)
 rm -r bin/mac-release
 mkdir -p bin/mac-release
 
+# Pack assets into bin/mac-release/assets.pack, or compile them into the executable with --embed-assets
+g++ -o bin/mac-release/asset_packer tools/asset_packer.cpp -DMACOS -std=c++17 -Wall -O2
+embed_flags=""
+if [ "$1" == "--embed-assets" ]; then
+	./bin/mac-release/asset_packer --cpp assets bin/mac-release/embedded_assets.cpp
+	embed_flags="bin/mac-release/embedded_assets.cpp -DEMBED_ASSETS -Isrc"
+else
+	./bin/mac-release/asset_packer assets bin/mac-release/assets.pack
+fi
+
 # Compile @todo: compile .c files with gcc
-g++ -o bin/mac-release/BreakoutCppMac_$version.app src/*.cpp third-party/src/*.c -DMACOS -DVERSION=\"$version\" -Ithird-party/include -Lthird-party/lib-mac -lglfw3 -framework Cocoa -framework OpenGL -framework IOKit -Wall -O2
+g++ -o bin/mac-release/BreakoutCppMac_$version.app src/*.cpp third-party/src/*.c $embed_flags -DMACOS -DVERSION=\"$version\" -Ithird-party/include -Lthird-party/lib-mac -lglfw3 -framework Cocoa -framework OpenGL -framework IOKit -std=c++17 -Wall -O2
+
+# Compile vectorized environment library for training agents
+g++ -o bin/mac-release/libbreakout_vecenv.dylib src/vecenv.cpp src/game.cpp src/lanes.cpp src/metrics.cpp third-party/src/*.c -DMACOS -Ithird-party/include -shared -fPIC -std=c++17 -Wall -O2
 
-# Copy shaders to bin/mac-release
-cp -r assets/shaders bin/mac-release/shaders
+# Compile level generator (see tools/level_generator.cpp)
+g++ -o bin/mac-release/level_generator tools/level_generator.cpp -DMACOS -std=c++17 -Wall -O2
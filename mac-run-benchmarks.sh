@@ -0,0 +1,21 @@
+#!/bin/bash
+set -e
+
+# Clear or create bin/benchmarks
+rm -rf bin/benchmarks
+mkdir -p bin/benchmarks
+
+# Compile benchmarks
+g++ -o bin/benchmarks/collision_benchmark benchmarks/collision_benchmark.cpp -DMACOS -std=c++17 -Wall -O2
+
+# Run benchmarks
+./bin/benchmarks/collision_benchmark --json bin/benchmarks/collision.json
+
+# Game benchmark, compared against the baseline in bin/benchmarks-baseline.txt when there is one
+g++ -o bin/benchmarks/game_benchmark benchmarks/game_benchmark.cpp src/game.cpp src/lanes.cpp src/metrics.cpp third-party/src/*.c -DMACOS -Ithird-party/include -std=c++17 -Wall -O2
+
+if [ -f bin/benchmarks-baseline.txt ]; then
+	./bin/benchmarks/game_benchmark --json bin/benchmarks/game.json --baseline bin/benchmarks-baseline.txt --threshold 10
+else
+	./bin/benchmarks/game_benchmark --json bin/benchmarks/game.json --save-baseline bin/benchmarks-baseline.txt
+fi
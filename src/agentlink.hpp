@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <iostream>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "types.hpp"
+#include "game.hpp"
+
+/**
+ * Shared memory link that lets an out of process agent step the game.
+ *
+ * The link is a POSIX shared memory object holding a ring of slots. The agent
+ * writes an action into the next slot and bumps request_count, the game steps
+ * once for that slot, writes the observation back into the same slot and bumps
+ * response_count. Both sides spin-wait on the counters so there are no syscalls
+ * on the step path. The agent may queue up to agent_link_slot_count actions
+ * before it has to wait for a response.
+ */
+
+const uint32 agent_link_magic      = 0x4B4E4C42; // "BLNK"
+const uint32 agent_link_version    = 1;
+const uint32 agent_link_slot_count = 64;
+
+// Number of busy spins before the waiting side starts yielding its time slice
+const uint32 agent_link_spin_count = 4096;
+
+// Ticket agent_link_submit() returns when the link closed before the action could be queued
+const uint64 agent_link_closed_ticket = UINT64_MAX;
+
+// Written by the agent for each step
+struct AgentAction {
+	float64 delta_time; // Frame time to simulate, 0 uses 1/60
+	uint8   left_key_pressed;
+	uint8   right_key_pressed;
+	uint8   start_key_pressed;
+};
+
+struct AgentSlot {
+	AgentAction       action;      // Written by the agent
+	Game::Observation observation; // Written by the game after stepping
+};
+
+// Layout of the shared memory object
+struct AgentLink {
+	uint32 magic;
+	uint32 version;
+	uint32 slot_count;
+	uint32 slot_size;
+
+	// Counters live on their own cache lines so both sides don't fight over them
+	alignas(64) std::atomic<uint64> request_count;  // Written by the agent
+	alignas(64) std::atomic<uint64> response_count; // Written by the game
+	alignas(64) std::atomic<uint32> closed;         // Set by either side to end the session
+
+	alignas(64) AgentSlot slots[agent_link_slot_count];
+};
+
+static_assert(std::atomic<uint64>::is_always_lock_free, "Agent link counters must be lock free to live in shared memory");
+
+inline void agent_link_cpu_relax() {
+	#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+	#elif defined(__aarch64__)
+	asm volatile("yield");
+	#endif
+}
+
+/**
+ * Map the named shared memory object, creating it if create is true.
+ * @returns The link or NULL on failure
+ */
+AgentLink* agent_link_map(const char* name, bool create) {
+	int flags = create ? (O_CREAT | O_RDWR | O_TRUNC) : O_RDWR;
+	int fd = shm_open(name, flags, 0600);
+	if (fd < 0) {
+		std::cout << "Failed to open shared memory: " << name << std::endl;
+		return NULL;
+	}
+
+	if (create && ftruncate(fd, sizeof(AgentLink)) != 0) {
+		std::cout << "Failed to size shared memory: " << name << std::endl;
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	void* memory = mmap(NULL, sizeof(AgentLink), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd); // The mapping keeps the object alive
+	if (memory == MAP_FAILED) {
+		std::cout << "Failed to map shared memory: " << name << std::endl;
+		if (create) {
+			shm_unlink(name);
+		}
+		return NULL;
+	}
+
+	return (AgentLink*)memory;
+}
+
+/**
+ * Create the link on the game side (remember to call agent_link_destroy() after)
+ */
+AgentLink* agent_link_create(const char* name) {
+	AgentLink* link = agent_link_map(name, true);
+	if (link == NULL) {
+		return NULL;
+	}
+
+	// ftruncate zero fills, so the atomics start at 0
+	link->slot_count = agent_link_slot_count;
+	link->slot_size = sizeof(AgentSlot);
+	link->version = agent_link_version;
+	std::atomic_thread_fence(std::memory_order_release);
+	link->magic = agent_link_magic;
+	return link;
+}
+
+/**
+ * Attach to a link created by the game (remember to call agent_link_detach() after)
+ */
+AgentLink* agent_link_attach(const char* name) {
+	AgentLink* link = agent_link_map(name, false);
+	if (link == NULL) {
+		return NULL;
+	}
+
+	if (link->magic != agent_link_magic || link->version != agent_link_version
+			|| link->slot_count != agent_link_slot_count || link->slot_size != sizeof(AgentSlot))
+	{
+		std::cout << "Shared memory layout does not match this build: " << name << std::endl;
+		munmap(link, sizeof(AgentLink));
+		return NULL;
+	}
+
+	return link;
+}
+
+/**
+ * Spin until counter is greater than value or the link is closed.
+ * @returns False if the link was closed
+ */
+bool agent_link_wait(AgentLink* link, std::atomic<uint64>* counter, uint64 value) {
+	uint32 spins = 0;
+	while (counter->load(std::memory_order_acquire) <= value) {
+		if (link->closed.load(std::memory_order_relaxed)) {
+			return false;
+		}
+
+		if (spins < agent_link_spin_count) {
+			spins++;
+			agent_link_cpu_relax();
+		} else {
+			sched_yield();
+		}
+	}
+	return true;
+}
+
+//
+// Agent side
+//
+
+/**
+ * Queue an action without waiting for the result.
+ * @returns The ticket to pass to agent_link_receive(), agent_link_closed_ticket if the link closed while the ring was full
+ */
+uint64 agent_link_submit(AgentLink* link, const AgentAction* action) {
+	uint64 ticket = link->request_count.load(std::memory_order_relaxed);
+
+	// Don't overwrite a slot the game hasn't answered yet
+	if (ticket >= agent_link_slot_count && !agent_link_wait(link, &link->response_count, ticket - agent_link_slot_count)) {
+		return agent_link_closed_ticket;
+	}
+
+	link->slots[ticket % agent_link_slot_count].action = *action;
+	link->request_count.store(ticket + 1, std::memory_order_release);
+	return ticket;
+}
+
+/**
+ * Wait for the game to step a submitted action.
+ * @returns The observation after the step (valid until the slot is reused) or NULL if the link closed
+ */
+const Game::Observation* agent_link_receive(AgentLink* link, uint64 ticket) {
+	if (ticket == agent_link_closed_ticket || !agent_link_wait(link, &link->response_count, ticket)) {
+		return NULL;
+	}
+	return &link->slots[ticket % agent_link_slot_count].observation;
+}
+
+/**
+ * Step the game once and wait for the observation.
+ */
+const Game::Observation* agent_link_step(AgentLink* link, const AgentAction* action) {
+	return agent_link_receive(link, agent_link_submit(link, action));
+}
+
+void agent_link_detach(AgentLink* link) {
+	link->closed.store(1, std::memory_order_relaxed);
+	munmap(link, sizeof(AgentLink));
+}
+
+//
+// Game side
+//
+
+/**
+ * Run the game headless on a grid of tiles and step it for every action
+ * the agent submits until the agent closes the link.
+ * @returns Process exit code
+ */
+int agent_link_serve(const char* name, Vec2Int grid_size) {
+	AgentLink* link = agent_link_create(name);
+	if (link == NULL) {
+		return 1;
+	}
+
+	Game::Data* game_data = Game::init_headless(grid_size);
+
+	Game::Input input = {};
+	std::cout << "Waiting for agent on shared memory: " << name << std::endl;
+
+	uint64 step = 0;
+	while (agent_link_wait(link, &link->request_count, step)) {
+		AgentSlot* slot = &link->slots[step % agent_link_slot_count];
+
+		input.delta_time = slot->action.delta_time > 0.0 ? slot->action.delta_time : 1.0 / 60.0;
+		input.frame_time += input.delta_time;
+		input.left_key_pressed = slot->action.left_key_pressed;
+		input.right_key_pressed = slot->action.right_key_pressed;
+		input.start_key_pressed_prev = input.start_key_pressed;
+		input.start_key_pressed = slot->action.start_key_pressed;
+
+		Game::update(&input, game_data);
+		Game::observe(game_data, &slot->observation);
+
+		step++;
+		link->response_count.store(step, std::memory_order_release);
+	}
+
+	std::cout << "Agent closed link after " << step << " steps." << std::endl;
+	Game::free_headless(game_data);
+	link->closed.store(1, std::memory_order_relaxed);
+	munmap(link, sizeof(AgentLink));
+	shm_unlink(name);
+	return 0;
+}
@@ -0,0 +1,116 @@
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include "alloctrack.hpp"
+
+#ifdef WINDOWS
+#include <malloc.h>
+#endif
+
+// Plain thread local integers, they must not allocate or run constructors since operator new uses them
+thread_local uint64 thread_allocation_count = 0;
+thread_local uint64 thread_allocation_bytes = 0;
+
+std::atomic<bool>   alloc_tracking_armed(false);
+std::atomic<bool>   alloc_tracking_abort(false);
+std::atomic<uint64> alloc_tracking_violations(0);
+
+AllocationCounts thread_allocation_counts() {
+	AllocationCounts counts;
+	counts.count = thread_allocation_count;
+	counts.bytes = thread_allocation_bytes;
+	return counts;
+}
+
+void alloc_tracking_arm(bool abort_on_allocation) {
+	alloc_tracking_abort.store(abort_on_allocation, std::memory_order_relaxed);
+	alloc_tracking_armed.store(true, std::memory_order_relaxed);
+}
+
+uint64 alloc_tracking_violation_count() {
+	return alloc_tracking_violations.load(std::memory_order_relaxed);
+}
+
+void alloc_tracking_check(const char* name, AllocationCounts start) {
+	uint64 count = thread_allocation_count - start.count;
+	if (count == 0 || !alloc_tracking_armed.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	alloc_tracking_violations.fetch_add(1, std::memory_order_relaxed);
+	std::cout << "Warning: " << name << " made " << count << " heap allocations (" 
+			<< thread_allocation_bytes - start.bytes << " bytes)." << std::endl;
+
+	if (alloc_tracking_abort.load(std::memory_order_relaxed)) {
+		std::cout << "Aborting, allocations are not allowed in " << name << "." << std::endl;
+		abort();
+	}
+}
+
+#ifdef ALLOC_TRACKING
+
+//
+// Global operator new and delete replacements
+//
+
+void* tracked_allocate(size_t size, size_t alignment, bool throw_on_failure) {
+	thread_allocation_count++;
+	thread_allocation_bytes += size;
+
+	if (size == 0) {
+		size = 1;
+	}
+
+	void* memory;
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		memory = malloc(size);
+	} else {
+		#ifdef WINDOWS
+		memory = _aligned_malloc(size, alignment);
+		#else
+		if (posix_memalign(&memory, alignment, size) != 0) {
+			memory = NULL;
+		}
+		#endif
+	}
+
+	if (memory == NULL && throw_on_failure) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void tracked_free(void* memory, size_t alignment) {
+	#ifdef WINDOWS
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		_aligned_free(memory);
+		return;
+	}
+	#endif
+	free(memory);
+}
+
+void* operator new(size_t size) { return tracked_allocate(size, 0, true); }
+void* operator new[](size_t size) { return tracked_allocate(size, 0, true); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return tracked_allocate(size, 0, false); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return tracked_allocate(size, 0, false); }
+void* operator new(size_t size, std::align_val_t alignment) { return tracked_allocate(size, (size_t)alignment, true); }
+void* operator new[](size_t size, std::align_val_t alignment) { return tracked_allocate(size, (size_t)alignment, true); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return tracked_allocate(size, (size_t)alignment, false); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return tracked_allocate(size, (size_t)alignment, false); }
+
+void operator delete(void* memory) noexcept { tracked_free(memory, 0); }
+void operator delete[](void* memory) noexcept { tracked_free(memory, 0); }
+void operator delete(void* memory, size_t) noexcept { tracked_free(memory, 0); }
+void operator delete[](void* memory, size_t) noexcept { tracked_free(memory, 0); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { tracked_free(memory, 0); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { tracked_free(memory, 0); }
+void operator delete(void* memory, std::align_val_t alignment) noexcept { tracked_free(memory, (size_t)alignment); }
+void operator delete[](void* memory, std::align_val_t alignment) noexcept { tracked_free(memory, (size_t)alignment); }
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept { tracked_free(memory, (size_t)alignment); }
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept { tracked_free(memory, (size_t)alignment); }
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept { tracked_free(memory, (size_t)alignment); }
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept { tracked_free(memory, (size_t)alignment); }
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "types.hpp"
+
+/**
+ * Heap allocation tracking for keeping the frame loop allocation free.
+ *
+ * With ALLOC_TRACKING defined, alloctrack.cpp replaces the global operator new
+ * and delete with versions that count allocations per thread. Code that must not
+ * allocate once the game is running puts ASSERT_NO_ALLOCATIONS("Name") at the
+ * start of a block. After alloc_tracking_arm() is called, an allocation anywhere
+ * inside such a block (including in functions it calls) is reported, or aborts
+ * the program in strict mode.
+ *
+ * Only operator new is tracked. C allocations made by libraries (ex. the OpenGL
+ * driver or GLFW) can't be hooked portably and are not counted.
+ */
+
+struct AllocationCounts {
+	uint64 count;
+	uint64 bytes;
+};
+
+// Allocations made by the calling thread so far, always zero unless ALLOC_TRACKING is defined
+AllocationCounts thread_allocation_counts();
+
+/**
+ * Start checking ASSERT_NO_ALLOCATIONS blocks, call once the game reached a steady
+ * state (lazily created buffers are allowed to allocate before that)
+ * @param abort_on_allocation Abort on the first allocation instead of reporting it
+ */
+void alloc_tracking_arm(bool abort_on_allocation);
+
+// Number of ASSERT_NO_ALLOCATIONS blocks that allocated since alloc_tracking_arm()
+uint64 alloc_tracking_violation_count();
+
+// Report the block if it allocated since start (use ASSERT_NO_ALLOCATIONS instead)
+void alloc_tracking_check(const char* name, AllocationCounts start);
+
+struct NoAllocationScope {
+	const char*      name;
+	AllocationCounts start;
+
+	NoAllocationScope(const char* name) : name(name), start(thread_allocation_counts()) {}
+	~NoAllocationScope() { alloc_tracking_check(name, start); }
+};
+
+#ifdef ALLOC_TRACKING
+#define ALLOC_CONCAT_(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_(a, b)
+#define ASSERT_NO_ALLOCATIONS(name) NoAllocationScope ALLOC_CONCAT(no_allocation_scope_, __LINE__)(name)
+#else
+#define ASSERT_NO_ALLOCATIONS(name)
+#endif
@@ -0,0 +1,85 @@
+#include <iostream>
+#include "arena.hpp"
+
+#ifdef WINDOWS
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#ifdef MACOS
+#include <mach/vm_statistics.h>
+#endif
+#endif
+
+/**
+ * Map capacity bytes of zeroed memory, capacity is a multiple of arena_huge_page_size when huge_pages is set
+ * @param huge_pages Set to false if huge pages were requested but aren't used
+ */
+uint8* map_arena_memory(uint64 capacity, bool* huge_pages) {
+	#ifdef WINDOWS
+	// Large pages need the "Lock pages in memory" privilege, which most accounts don't have
+	if (*huge_pages && GetLargePageMinimum() != 0 && capacity % GetLargePageMinimum() == 0) {
+		void* memory = VirtualAlloc(NULL, capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (memory != NULL) {
+			return (uint8*)memory;
+		}
+	}
+	*huge_pages = false;
+	return (uint8*)VirtualAlloc(NULL, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+	#else
+	#ifdef MACOS
+	// Superpages are only available on Intel macs
+	if (*huge_pages) {
+		void* memory = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+		if (memory != MAP_FAILED) {
+			return (uint8*)memory;
+		}
+		*huge_pages = false;
+	}
+	#endif
+
+	void* memory = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (memory == MAP_FAILED) {
+		return NULL;
+	}
+
+	#if defined(MADV_HUGEPAGE)
+	// Transparent huge pages, the kernel backs the memory with huge pages when it can
+	if (*huge_pages && madvise(memory, capacity, MADV_HUGEPAGE) != 0) {
+		*huge_pages = false;
+	}
+	#elif !defined(MACOS)
+	*huge_pages = false;
+	#endif
+	return (uint8*)memory;
+	#endif
+}
+
+Arena* create_arena(uint64 capacity, bool huge_pages) {
+	if (huge_pages) {
+		capacity = (capacity + arena_huge_page_size - 1) / arena_huge_page_size * arena_huge_page_size;
+	}
+
+	uint8* memory = map_arena_memory(capacity, &huge_pages);
+	if (memory == NULL) {
+		std::cout << "Failed to map arena memory: " << capacity << " bytes" << std::endl;
+		return NULL;
+	}
+
+	Arena* arena = new Arena;
+	arena->memory = memory;
+	arena->capacity = capacity;
+	arena->used = 0;
+	arena->peak = 0;
+	arena->huge_pages = huge_pages;
+	return arena;
+}
+
+void free_arena(Arena* arena) {
+	#ifdef WINDOWS
+	VirtualFree(arena->memory, 0, MEM_RELEASE);
+	#else
+	munmap(arena->memory, arena->capacity);
+	#endif
+	delete arena;
+}
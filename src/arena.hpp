@@ -0,0 +1,75 @@
+#pragma once
+
+#include <iostream>
+#include <stdint.h>
+#include "types.hpp"
+
+/**
+ * Linear (bump) allocator over one block of memory.
+ *
+ * Allocating moves an offset forward and memory is only freed all at once with
+ * arena_reset(), so there is no per allocation bookkeeping and nothing to free.
+ * The game keeps long lived data in a permanent arena that lives as long as the
+ * program, and transient data in a frame arena that the platform layer resets at
+ * the start of every frame (see Game::Input).
+ *
+ * Pushing is header only so game code can use arenas it is handed, the memory
+ * itself is mapped by create_arena() in arena.cpp.
+ */
+
+const uint64 arena_default_alignment = 64;              // Cache line, also enough for any SIMD vector used
+const uint64 arena_huge_page_size    = 2 * 1024 * 1024; // Capacity is rounded up to this when using huge pages
+
+struct Arena {
+	uint8* memory;
+	uint64 capacity;
+	uint64 used;
+	uint64 peak;       // Highest used has been since creation
+	bool   huge_pages; // True if the memory ended up backed by huge pages
+};
+
+/**
+ * Map a new arena (remember to call free_arena() after)
+ * @param huge_pages Try to back the memory with huge pages, falls back to normal pages if not available
+ * @returns NULL if the memory couldn't be mapped
+ */
+Arena* create_arena(uint64 capacity, bool huge_pages);
+
+void free_arena(Arena* arena);
+
+/**
+ * Allocate size bytes, the memory is not cleared
+ * @param alignment Power of two
+ * @returns NULL if the arena is full
+ */
+inline void* arena_push(Arena* arena, uint64 size, uint64 alignment = arena_default_alignment) {
+	uint64 address = (uint64)(uintptr_t)arena->memory + arena->used;
+	uint64 start = ((address + alignment - 1) & ~(alignment - 1)) - (uint64)(uintptr_t)arena->memory;
+	if (start + size > arena->capacity) {
+		std::cout << "Arena out of memory: " << size << " bytes requested, "
+				<< arena->capacity - arena->used << " of " << arena->capacity << " left." << std::endl;
+		return NULL;
+	}
+
+	arena->used = start + size;
+	if (arena->used > arena->peak) {
+		arena->peak = arena->used;
+	}
+	return arena->memory + start;
+}
+
+/**
+ * Allocate an array of count T, the elements are not constructed
+ */
+template<typename T>
+inline T* arena_push_array(Arena* arena, uint64 count) {
+	uint64 alignment = alignof(T) > arena_default_alignment ? alignof(T) : arena_default_alignment;
+	return (T*)arena_push(arena, sizeof(T) * count, alignment);
+}
+
+/**
+ * Free everything allocated from the arena
+ */
+inline void arena_reset(Arena* arena) {
+	arena->used = 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <thread>
+#include "types.hpp"
+#include "assetpack.hpp"
+#include "spscqueue.hpp"
+
+/**
+ * Background thread that loads a list of assets and posts each one to a
+ * completion queue as it's ready, so the main thread can keep rendering (ex. a
+ * loading screen) and only does the GPU uploads when it drains the queue.
+ *
+ * Assets come from the mapped asset pack, so loading one means paging it in
+ * and verifying its checksum, which is the slow part on a cold disk.
+ */
+
+const int32 asset_loader_max_requests = 64;
+
+struct AssetCompletion {
+	int32     request; // Index in the list passed to start_asset_loader()
+	bool      ok;      // False if the asset is missing or corrupted
+	AssetView view;
+};
+
+struct AssetLoader {
+	const AssetPack* pack;
+	const char*      requests[asset_loader_max_requests];
+	int32            request_count;
+	int32            completed_count; // Completions popped by the main thread
+
+	SpscQueue<AssetCompletion, asset_loader_max_requests> completions;
+	std::thread thread;
+};
+
+void asset_loader_thread(AssetLoader* loader) {
+	for (int32 i = 0; i < loader->request_count; i++) {
+		AssetCompletion completion;
+		completion.request = i;
+		completion.ok = asset_pack_find(loader->pack, loader->requests[i], &completion.view);
+
+		// The queue holds every request so this never fails
+		spsc_push(&loader->completions, completion);
+	}
+}
+
+/**
+ * Start loading the named assets (remember to call free_asset_loader() after)
+ * @param names Must stay valid until the loader is freed
+ */
+AssetLoader* start_asset_loader(const AssetPack* pack, const char* const* names, int32 count) {
+	AssetLoader* loader = new AssetLoader;
+	loader->pack = pack;
+	loader->request_count = count < asset_loader_max_requests ? count : asset_loader_max_requests;
+	loader->completed_count = 0;
+	for (int32 i = 0; i < loader->request_count; i++) {
+		loader->requests[i] = names[i];
+	}
+	spsc_reset(&loader->completions);
+
+	loader->thread = std::thread(asset_loader_thread, loader);
+	return loader;
+}
+
+/**
+ * Take the next finished asset, call from one thread only
+ * @returns False if nothing finished since the last call
+ */
+bool asset_loader_poll(AssetLoader* loader, AssetCompletion* completion) {
+	if (!spsc_pop(&loader->completions, completion)) {
+		return false;
+	}
+	loader->completed_count++;
+	return true;
+}
+
+bool asset_loader_done(const AssetLoader* loader) {
+	return loader->completed_count == loader->request_count;
+}
+
+/**
+ * Wait for the thread to finish and free the loader
+ */
+void free_asset_loader(AssetLoader* loader) {
+	loader->thread.join();
+	delete loader;
+}
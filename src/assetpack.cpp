@@ -0,0 +1,40 @@
+#include <iostream>
+#include "assetpack.hpp"
+
+AssetPack* open_asset_pack(const char* path) {
+	AssetPack* pack = new AssetPack;
+	pack->embedded = false;
+
+	if (!map_file(path, &pack->file)) {
+		std::cout << "Failed to open asset pack: " << path << std::endl;
+		delete pack;
+		return NULL;
+	}
+
+	if (pack->file.memory == NULL || !asset_pack_init(pack, pack->file.memory, pack->file.size)) {
+		std::cout << "Not a valid asset pack: " << path << std::endl;
+		close_asset_pack(pack);
+		return NULL;
+	}
+	return pack;
+}
+
+#ifdef EMBED_ASSETS
+AssetPack* open_embedded_asset_pack() {
+	AssetPack* pack = new AssetPack;
+	pack->embedded = true;
+	if (!asset_pack_init(pack, embedded_asset_pack, embedded_asset_pack_size)) {
+		std::cout << "Embedded asset pack is not valid." << std::endl;
+		delete pack;
+		return NULL;
+	}
+	return pack;
+}
+#endif
+
+void close_asset_pack(AssetPack* pack) {
+	if (!pack->embedded) {
+		unmap_file(&pack->file);
+	}
+	delete pack;
+}
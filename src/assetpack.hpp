@@ -0,0 +1,155 @@
+#pragma once
+
+#include <iostream>
+#include <string.h>
+#include "types.hpp"
+#include "mappedfile.hpp"
+
+/**
+ * Single file archive of everything in assets/, built by tools/asset_packer.cpp.
+ *
+ * The platform layer maps the pack into memory once at startup and the game
+ * reads assets straight out of the mapping, so loading doesn't copy anything
+ * and only one file is opened however many assets there are.
+ *
+ * Builds with EMBED_ASSETS compile the pack into the executable instead
+ * (asset_packer --cpp), so the game doesn't touch the filesystem at all.
+ *
+ * File layout: AssetPackHeader, asset_count AssetPackEntries sorted by name,
+ * then the asset data. Every asset starts on an asset_pack_alignment boundary
+ * and is followed by a null byte (not counted in its size), so text assets can
+ * also be used as C strings.
+ */
+
+const uint32 asset_pack_magic          = 0x4B415042; // "BPAK"
+const uint32 asset_pack_version        = 1;
+const uint64 asset_pack_alignment      = 64;
+const int32  asset_pack_name_capacity  = 48; // Includes the null terminator
+
+struct AssetPackHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 asset_count;
+	uint32 reserved;
+	uint64 file_size;
+};
+
+struct AssetPackEntry {
+	char   name[asset_pack_name_capacity]; // Path relative to assets/ with '/' separators
+	uint64 offset;                         // From the start of the file
+	uint64 size;
+	uint32 checksum;                       // asset_checksum() of the data
+	uint32 reserved;
+};
+
+// Read only view of an asset inside a pack
+struct AssetView {
+	const char* data; // Null terminated
+	uint64      size;
+};
+
+struct AssetPack {
+	const uint8*          memory;
+	uint64                size;
+	const AssetPackEntry* entries;
+	uint32                entry_count;
+
+	MappedFile file;
+	bool       embedded; // Points at embedded_asset_pack, there's nothing to unmap
+};
+
+#ifdef EMBED_ASSETS
+// Generated by asset_packer --cpp
+extern const uint8  embedded_asset_pack[];
+extern const uint64 embedded_asset_pack_size;
+
+/**
+ * Open the pack compiled into the executable (remember to call close_asset_pack() after)
+ * @returns NULL if the embedded pack isn't valid
+ */
+AssetPack* open_embedded_asset_pack();
+#endif
+
+/**
+ * Map a pack file into memory (remember to call close_asset_pack() after)
+ * @returns NULL if the file can't be opened or isn't a valid pack
+ */
+AssetPack* open_asset_pack(const char* path);
+
+void close_asset_pack(AssetPack* pack);
+
+/**
+ * FNV-1a hash used to detect corrupted assets
+ */
+inline uint32 asset_checksum(const uint8* data, uint64 size) {
+	uint32 hash = 2166136261u;
+	for (uint64 i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Point a pack at its file contents and check the header and index are in bounds
+ * @returns False if the memory isn't a valid pack
+ */
+inline bool asset_pack_init(AssetPack* pack, const uint8* memory, uint64 size) {
+	if (size < sizeof(AssetPackHeader)) {
+		return false;
+	}
+
+	const AssetPackHeader* header = (const AssetPackHeader*)memory;
+	if (header->magic != asset_pack_magic || header->version != asset_pack_version || header->file_size != size
+			|| header->asset_count > (size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry)) {
+		return false;
+	}
+
+	const AssetPackEntry* entries = (const AssetPackEntry*)(memory + sizeof(AssetPackHeader));
+	for (uint32 i = 0; i < header->asset_count; i++) {
+		const AssetPackEntry* entry = &entries[i];
+		if (entry->name[asset_pack_name_capacity - 1] != '\0' || entry->offset > size || entry->size >= size - entry->offset
+				|| memory[entry->offset + entry->size] != '\0') {
+			return false;
+		}
+	}
+
+	pack->memory = memory;
+	pack->size = size;
+	pack->entries = entries;
+	pack->entry_count = header->asset_count;
+	return true;
+}
+
+/**
+ * Look up an asset by its path relative to assets/ (ex. "shaders/circle.vs")
+ * @returns False if the asset is missing or corrupted
+ */
+inline bool asset_pack_find(const AssetPack* pack, const char* name, AssetView* view) {
+	// Binary search, entries are sorted by name
+	uint32 low = 0;
+	uint32 high = pack->entry_count;
+	while (low < high) {
+		uint32 middle = (low + high) / 2;
+		int compare = strcmp(pack->entries[middle].name, name);
+		if (compare == 0) {
+			const AssetPackEntry* entry = &pack->entries[middle];
+			if (asset_checksum(pack->memory + entry->offset, entry->size) != entry->checksum) {
+				std::cout << "Asset is corrupted: " << name << std::endl;
+				return false;
+			}
+
+			view->data = (const char*)(pack->memory + entry->offset);
+			view->size = entry->size;
+			return true;
+		}
+
+		if (compare < 0) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	std::cout << "Asset not found: " << name << std::endl;
+	return false;
+}
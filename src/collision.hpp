@@ -94,24 +94,22 @@ bool moving_circle_to_retangle_collision_quick_check(Vec2 p1, Vec2 p2, float32 r
 }
 
 /**
- * Check for a collision between a moving circle and a rectangle.
+ * Exact check for a collision between a moving circle and a rectangle, 
+ * without first running moving_circle_to_retangle_collision_quick_check().
+ * Useful when the caller wants to count how often the quick check rejects.
  * @param p1 Start position of circle
  * @param p2 End position of circle
  * @param radius Radius of circle
- * @param radius Radius of circle
  * @param center Center of the rectangle
+ * @param size Size of the rectangle
  * @param distance Distance from p1 to the collision point
  * @param point Position of the collision
  * @param normal Normal of the collision
  * @returns True if there was a collision
  */
-bool moving_circle_to_retangle_collision_check(Vec2 p1, Vec2 p2, float32 radius, Vec2 center, Vec2 size, 
+bool moving_circle_to_retangle_collision_narrow_check(Vec2 p1, Vec2 p2, float32 radius, Vec2 center, Vec2 size, 
 		float32* distance, Vec2* point, Vec2* normal) 
 {
-	if (!moving_circle_to_retangle_collision_quick_check(p1, p2, radius, center, size)) {
-		return false;
-	}
-
 	Vec2 delta = p2 - p1;
 	Vec2 direction = normalize(delta);
 	float32 delta_mag = magnitude(delta);
@@ -217,3 +215,25 @@ bool moving_circle_to_retangle_collision_check(Vec2 p1, Vec2 p2, float32 radius,
 
 	return *distance < delta_mag;
 }
+
+/**
+ * Check for a collision between a moving circle and a rectangle.
+ * @param p1 Start position of circle
+ * @param p2 End position of circle
+ * @param radius Radius of circle
+ * @param center Center of the rectangle
+ * @param size Size of the rectangle
+ * @param distance Distance from p1 to the collision point
+ * @param point Position of the collision
+ * @param normal Normal of the collision
+ * @returns True if there was a collision
+ */
+bool moving_circle_to_retangle_collision_check(Vec2 p1, Vec2 p2, float32 radius, Vec2 center, Vec2 size, 
+		float32* distance, Vec2* point, Vec2* normal) 
+{
+	if (!moving_circle_to_retangle_collision_quick_check(p1, p2, radius, center, size)) {
+		return false;
+	}
+
+	return moving_circle_to_retangle_collision_narrow_check(p1, p2, radius, center, size, distance, point, normal);
+}
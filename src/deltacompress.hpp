@@ -0,0 +1,108 @@
+#pragma once
+
+#include "types.hpp"
+
+/**
+ * Delta compression for snapshots of the same size.
+ *
+ * A delta is the XOR of two snapshots, run-length encoded as a list of
+ * (unchanged byte count, changed byte count, changed bytes) runs with the
+ * counts stored as varints. XOR is its own inverse, so applying a delta to
+ * either snapshot gives the other one. This means a history of deltas can
+ * be stepped backwards from the latest snapshot or forwards from a keyframe.
+ */
+
+/**
+ * Max number of bytes delta_encode() can write for snapshots of the given size
+ */
+inline int32 delta_max_encoded_size(int32 size) {
+	// Worst case alternates 1 changed and 2 unchanged bytes, each run costs at most 2 count bytes
+	return size + (size / 3 + 1) * 4 + 10;
+}
+
+inline uint8* delta_write_varint(uint8* out, uint32 value) {
+	while (value >= 0x80) {
+		*out++ = (uint8)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8)value;
+	return out;
+}
+
+inline const uint8* delta_read_varint(const uint8* in, const uint8* end, uint32* value) {
+	*value = 0;
+	for (int shift = 0; in < end && shift < 32; shift += 7) {
+		uint8 byte = *in++;
+		*value |= (uint32)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return in;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Encode the difference between two snapshots.
+ * @param out Must hold delta_max_encoded_size(size) bytes
+ * @returns Number of bytes written to out
+ */
+inline int32 delta_encode(const uint8* prev, const uint8* cur, int32 size, uint8* out) {
+	uint8* out_start = out;
+	int32 i = 0;
+	while (i < size) {
+		int32 unchanged_start = i;
+		while (i < size && prev[i] == cur[i]) {
+			i++;
+		}
+
+		// Changed runs absorb single unchanged bytes, starting a new run would cost more
+		int32 changed_start = i;
+		while (i < size && (prev[i] != cur[i] || (i + 1 < size && prev[i + 1] != cur[i + 1]))) {
+			i++;
+		}
+
+		out = delta_write_varint(out, changed_start - unchanged_start);
+		out = delta_write_varint(out, i - changed_start);
+		for (int32 j = changed_start; j < i; j++) {
+			*out++ = prev[j] ^ cur[j];
+		}
+	}
+	return (int32)(out - out_start);
+}
+
+/**
+ * Write a run of unchanged bytes, so deltas encoded from parts of two snapshots
+ * can be joined into a delta of the whole snapshots
+ * @returns The end of the run in out
+ */
+inline uint8* delta_write_unchanged(uint8* out, int32 count) {
+	out = delta_write_varint(out, count);
+	return delta_write_varint(out, 0);
+}
+
+/**
+ * Apply a delta in place, turning one of the snapshots it was encoded from into the other.
+ * @returns False if the delta is corrupt or doesn't match the snapshot size
+ */
+inline bool delta_apply(uint8* snapshot, int32 size, const uint8* delta, int32 delta_size) {
+	const uint8* in = delta;
+	const uint8* end = delta + delta_size;
+	int32 i = 0;
+	while (in < end) {
+		uint32 unchanged, changed;
+		in = delta_read_varint(in, end, &unchanged);
+		if (in == NULL) {
+			return false;
+		}
+		in = delta_read_varint(in, end, &changed);
+		if (in == NULL || (int64)i + unchanged + changed > size || (int64)changed > end - in) {
+			return false;
+		}
+
+		i += unchanged;
+		for (uint32 j = 0; j < changed; j++) {
+			snapshot[i++] ^= *in++;
+		}
+	}
+	return i == size;
+}
@@ -1,42 +1,42 @@
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <math.h>
+#include <new>
+#include <string.h>
 
 #include "game.hpp"
 #include "shader.hpp"
-#include "fileloader.hpp"
+#include "shadercache.hpp"
+#include "arena.hpp"
+#include "assetpack.hpp"
+#include "assetloader.hpp"
+#include "level.hpp"
 #include "vector.hpp"
 #include "collision.hpp"
+#include "gamecommon.hpp"
+#include "deltacompress.hpp"
+#include "threadpool.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
+#include "alloctrack.hpp"
 
 using namespace Game;
 
-const float32 PI = 3.14159265;
+const int32 rewind_frame_count     = 60 * 60 * 60; // Number of frames that can be rewound (1 hour at 60 fps)
+const int32 rewind_bytes_per_frame = 32;           // Average encoded delta size the rewind buffer is sized for
+const int32 rewind_max_changed_tiles = 32;         // Tiles changed between recorded frames before recording compares every tile
 
-// Size of the window in world units (Origin is in the center of the window)
-const Vec2 world_size = Vec2(16, 9);
+const int32   trajectory_preview_bounces  = 20;   // Bounces drawn when the trajectory overlay is on
+const float32 trajectory_dot_spacing      = 0.3f; // Distance between the dots of the trajectory overlay
+const float32 trajectory_dot_radius       = 0.05f;
 
-const int     tile_grid_size_x   = 12; // Number of tile columns
-const int     tile_grid_size_y   = 3;  // Number of tile rows
-const Vec2Int tile_grid_size     = Vec2Int(tile_grid_size_x, tile_grid_size_y);
-const int32   tile_count         = tile_grid_size_x * tile_grid_size_y;
-
-const Vec2    tile_size          = Vec2(1.0f, 0.5f);  // Size of tile in world units
-const Vec2    tile_grid_offset   = Vec2(0.0f, -1.0f); // Grid offset from the top of the window
-
-const float32 paddle_start_pos_x = 0.0f;              // Start x position of the paddle
-const float32 paddle_pos_y       = -4.0f;             // Constant y position of the paddle
-const Vec2    paddle_size        = Vec2(2.0f, 0.25f); // Size of the paddle in world units
-const float32 paddle_speed       = 6.0f;              // Horizontal speed of the paddle in units per second
-
-const Vec2    ball_start_pos     = Vec2(0.0f, 0.0f);  // World start position of the ball
-const float32 ball_radius        = 0.2f;              // Radius of the ball in world units
-const float32 ball_base_speed    = 4.5f;              // Ball speed on level 1
-const float32 ball_level_speed   = 0.5f;              // Speed the ball increases by every level
-
-// When the ball hits near the edges of the paddle the ball bounces off 
-// with extra rotation, this gives the player a bit of control over where
-// the ball goes. This is the max addition rotation that can be applied to 
-// the ball during the paddle bounce in radians.
-const float32 ball_paddle_max_rotation = 15.0f * (3.14159f / 180.0f);
+const int32   autopilot_rollouts_per_move = 32;         // Simulated futures for each possible first move
+const int32   autopilot_horizon_frames    = 120;        // How far ahead each future is simulated
+const int32   autopilot_move_frames       = 10;         // Frames a move is held before a future picks a new one
+const float64 autopilot_frame_time        = 1.0 / 60.0; // Frame time used for the simulations
+const float32 autopilot_life_lost_score   = -1000.0f;
+const float32 autopilot_level_score       = 100.0f;
 
 enum GameState {
 	PAUSED,
@@ -44,15 +44,12 @@ enum GameState {
 	GAME_OVER
 };
 
-struct Tile {
-	Vec2 pos;
-	int32 health;
-};
-
 /**
- * This is the data for the entire game
+ * The simulation state of the game. This has no pointers or handles and the
+ * tiles of the level follow it in memory (see simulation_tiles()), so it can
+ * be snapshotted with a single memcpy of simulation_size() bytes.
  */
-struct Game::Data {
+struct alignas(64) Simulation {
 	GameState state;
 	int32     score;
 	int32     level;
@@ -62,7 +59,212 @@ struct Game::Data {
 
 	Vec2 ball_pos;
 	Vec2 ball_vel;
-	Tile tiles[tile_count];
+
+	uint32 random_state; // Each game has its own generator so games can be stepped independently
+
+	// Layout of the level, only changes when a level is loaded (see level.hpp)
+	int32   tile_count;
+	Vec2Int grid_size;
+	Vec2    tile_size;
+	bool    free_positions; // Tiles aren't on the grid, so every tile is tested for collisions
+
+	int32 tiles_left; // Breakable tiles with health left, the level is cleared when this reaches 0
+};
+
+Tile* simulation_tiles(Simulation* sim) {
+	return (Tile*)(sim + 1);
+}
+
+const Tile* simulation_tiles(const Simulation* sim) {
+	return (const Tile*)(sim + 1);
+}
+
+/**
+ * Bytes of a simulation with its tiles, the tiles start on a cache line
+ */
+int32 simulation_size(int32 count) {
+	return (int32)(sizeof(Simulation) + count * sizeof(Tile));
+}
+
+/**
+ * Distance between simulations stored one after the other, so each starts on its own cache line
+ */
+int32 simulation_stride(int32 tile_capacity) {
+	return (simulation_size(tile_capacity) + alignof(Simulation) - 1) / alignof(Simulation) * alignof(Simulation);
+}
+
+struct RewindEntry {
+	int32 offset; // Offset in the delta ring
+	int32 size;
+};
+
+/**
+ * History of the simulation state for the last frames. Only the latest frame is 
+ * stored in full, older frames are stored as deltas (see deltacompress.hpp) 
+ * which are applied backwards from the latest frame when rewinding.
+ */
+struct Game::RewindBuffer {
+	Simulation* latest;        // Room for a simulation of tile_capacity tiles
+	int32       latest_size;   // Deltas are all this size, the buffer starts over when it changes (ex. a level is loaded)
+	int32       tile_capacity;
+	bool        has_latest;
+
+	uint8* deltas;          // Ring of encoded deltas, oldest are dropped when it fills up
+	int32  deltas_capacity;
+	int32  deltas_write;    // Offset the next delta is written to
+
+	RewindEntry* entries;   // Ring of deltas in the order they were recorded, entry i turns frame i into frame i - 1
+	int32        entries_capacity;
+	int32        first_entry;
+	int32        entry_count;
+
+	uint8* encode_buffer;   // Holds a delta before it's copied into the ring
+
+	uint64 generation;      // Changes whenever latest does, 0 if it has no latest frame
+};
+
+// Unique across all rewind buffers, so a game's tile changes are only used with the buffer they were tracked for
+std::atomic<uint64> rewind_generation_counter(0);
+
+uint64 next_rewind_generation() {
+	return ++rewind_generation_counter;
+}
+
+int32 rewind_deltas_capacity(int32 frame_count, int32 tile_capacity) {
+	return frame_count * rewind_bytes_per_frame + delta_max_encoded_size(simulation_size(tile_capacity));
+}
+
+int32 rewind_entries_capacity(int32 frame_count) {
+	// The latest frame is stored in full, so one less delta is needed
+	return frame_count > 1 ? frame_count - 1 : 1;
+}
+
+/**
+ * Bytes of a rewind buffer and its arrays, not counting alignment
+ */
+uint64 rewind_buffer_memory_size(int32 frame_count, int32 tile_capacity) {
+	return sizeof(RewindBuffer) + simulation_size(tile_capacity) + rewind_deltas_capacity(frame_count, tile_capacity) 
+			+ rewind_entries_capacity(frame_count) * sizeof(RewindEntry) + delta_max_encoded_size(simulation_size(tile_capacity));
+}
+
+/**
+ * Set up an empty rewind buffer for frame_count frames, the arrays must already be allocated
+ */
+void clear_rewind_buffer(RewindBuffer* buffer, int32 frame_count, int32 tile_capacity) {
+	buffer->has_latest = false;
+	buffer->generation = 0;
+	buffer->latest_size = 0;
+	buffer->tile_capacity = tile_capacity;
+	buffer->deltas_capacity = rewind_deltas_capacity(frame_count, tile_capacity);
+	buffer->deltas_write = 0;
+	buffer->entries_capacity = rewind_entries_capacity(frame_count);
+	buffer->first_entry = 0;
+	buffer->entry_count = 0;
+}
+
+/**
+ * Allocate a rewind buffer from an arena (freed with the arena)
+ * @returns NULL if the arena is full
+ */
+RewindBuffer* push_rewind_buffer(Arena* arena, int32 frame_count, int32 tile_capacity) {
+	RewindBuffer* buffer = arena_push_array<RewindBuffer>(arena, 1);
+	if (buffer == NULL) {
+		return NULL;
+	}
+	new (buffer) RewindBuffer;
+
+	buffer->latest = (Simulation*)arena_push(arena, simulation_size(tile_capacity));
+	buffer->deltas = arena_push_array<uint8>(arena, rewind_deltas_capacity(frame_count, tile_capacity));
+	buffer->entries = arena_push_array<RewindEntry>(arena, rewind_entries_capacity(frame_count));
+	buffer->encode_buffer = arena_push_array<uint8>(arena, delta_max_encoded_size(simulation_size(tile_capacity)));
+	if (buffer->latest == NULL || buffer->deltas == NULL || buffer->entries == NULL || buffer->encode_buffer == NULL) {
+		return NULL;
+	}
+
+	clear_rewind_buffer(buffer, frame_count, tile_capacity);
+	return buffer;
+}
+
+// Assets the game loads in the background, indexed by ShaderAsset
+const char* const shader_asset_names[] = {
+	"shaders/rectangle.vs",
+	"shaders/rectangle.fs",
+	"shaders/circle.vs",
+	"shaders/circle.fs"
+};
+
+enum ShaderAsset {
+	RECTANGLE_VERT_SHADER,
+	RECTANGLE_FRAG_SHADER,
+	CIRCLE_VERT_SHADER,
+	CIRCLE_FRAG_SHADER,
+	SHADER_ASSET_COUNT
+};
+
+/**
+ * Progress of the assets init() started loading, render() moves it along every frame
+ */
+struct AssetLoading {
+	AssetLoader* loader; // NULL once every asset arrived
+	AssetView    shader_sources[SHADER_ASSET_COUNT];
+
+	ShaderCache          shader_cache;
+	bool                 parallel_shader_compile; // Programs can be polled instead of waited on
+	bool                 shader_builds_started;
+	PendingCachedProgram rectangle_program;
+	PendingCachedProgram circle_program;
+};
+
+/**
+ * Tiles changed since the last frame recorded for rewinding, so recording a
+ * frame only compares those tiles instead of every tile of a big level
+ */
+struct TileChanges {
+	uint64 generation; // Of the rewind buffer whose latest frame the changes are since, 0 if none
+	int32  count;      // -1 if any tile may have changed
+	int32  tiles[rewind_max_changed_tiles];
+};
+
+/**
+ * Add a tile to the changes, changes can be NULL for games that aren't recorded
+ */
+void tile_changed(TileChanges* changes, int32 index) {
+	if (changes == NULL || changes->count < 0) {
+		return;
+	}
+	if (changes->count == rewind_max_changed_tiles) {
+		changes->count = -1;
+		return;
+	}
+	changes->tiles[changes->count++] = index;
+}
+
+void all_tiles_changed(TileChanges* changes) {
+	if (changes != NULL) {
+		changes->count = -1;
+	}
+}
+
+// Tile loops built for one grid size, picked when a level is loaded
+struct GridKernels;
+const GridKernels* select_grid_kernels(const Simulation* sim);
+
+/**
+ * This is the data for the entire game
+ */
+struct Game::Data {
+	Simulation* sim;           // Followed by its tiles
+	int32       tile_capacity; // Most tiles sim has room for, bigger levels can't be loaded
+
+	const GridKernels* kernels; // For the layout of sim, picked again whenever it may have changed
+
+	RewindBuffer* rewind_buffer; // Set for games with a window or with set_rewind_buffer()
+	TileChanges   tile_changes;  // Since the last frame recorded in rewind_buffer, other buffers compare every tile
+
+	LoadState     load_state;
+	AssetLoading* loading; // Only set for games with a window
+
+	bool collision_limit_hit; // Set if the last update hit the max collision iterations
 	
 	uint32 rectangle_shader;
 	uint32 circle_shader;
@@ -73,78 +275,193 @@ struct Game::Data {
  * Reset the ball and paddle position for the 
  * start of the game or start of a new level
  */
-void reset_ball_and_paddle(Data* data, float32 ball_speed) {
-	data->ball_pos = ball_start_pos;
-	float32 angle = (rand() / (float32)RAND_MAX) * (PI * 0.5f) + (PI * 0.25f); // From 45 to 135 degrees
-	data->ball_vel.x = ball_speed * cos(angle);
-	data->ball_vel.y = ball_speed * sin(angle);
+void reset_ball_and_paddle(Simulation* sim, float32 ball_speed) {
+	sim->ball_pos = ball_start_pos;
+	float32 angle = random_float(&sim->random_state) * (PI * 0.5f) + (PI * 0.25f); // From 45 to 135 degrees
+	sim->ball_vel.x = ball_speed * cos(angle);
+	sim->ball_vel.y = ball_speed * sin(angle);
+
+	sim->paddle_pos_x = paddle_start_pos_x;
+}
 
-	data->paddle_pos_x = paddle_start_pos_x;
+/**
+ * Give every tile its full health for the current level
+ */
+void refill_tiles(Simulation* sim) {
+	Tile* tiles = simulation_tiles(sim);
+	int32 tiles_left = 0;
+	for (int i = 0; i < sim->tile_count; i++) {
+		tiles[i].health = tiles[i].base_health * sim->level;
+		if (tiles[i].type == TILE_NORMAL && tiles[i].health > 0) {
+			tiles_left++;
+		}
+	}
+	sim->tiles_left = tiles_left;
 }
 
 /**
  * Reset the game data for a new game
  */
-void reset_game(Data* data) {
-	data->score = 0;
-	data->level = 1;
-	data->lives = 2;
-	reset_ball_and_paddle(data, ball_base_speed);
-	for (int i = 0; i < tile_count; i++) {
-		data->tiles[i].health = 1;
+void reset_game(Simulation* sim) {
+	sim->score = 0;
+	sim->level = 1;
+	sim->lives = 2;
+	reset_ball_and_paddle(sim, ball_base_speed);
+	refill_tiles(sim);
+}
+
+/**
+ * Lay out the built-in level, a full grid of tiles with one hit of health
+ * @param sim Must have room for grid_size.x * grid_size.y tiles
+ */
+void set_grid_level(Simulation* sim, Vec2Int grid_size) {
+	sim->tile_count = grid_size.x * grid_size.y;
+	sim->grid_size = grid_size;
+	sim->tile_size = grid_fit_tile_size(grid_size);
+	sim->free_positions = false;
+
+	Tile* tiles = simulation_tiles(sim);
+	for (int i = 0; i < sim->tile_count; i++) {
+		tiles[i].pos = grid_tile_position(grid_size, sim->tile_size, i);
+		tiles[i].health = 1;
+		tiles[i].base_health = 1;
+		tiles[i].type = TILE_NORMAL;
 	}
 }
 
-Data* Game::init(const Input* input) {
-	
-	//
-	// Initialize game data
-	//
-	Data* data = new Data;
+/**
+ * Initialize the simulation part of the game data on a full grid of tiles
+ * @param sim Memory for a simulation of tile_capacity tiles (see simulation_size()), at least the grid
+ */
+void init_data(Data* data, Simulation* sim, int32 tile_capacity, Vec2Int grid_size, uint32 seed) {
+	data->sim = sim;
+	data->tile_capacity = tile_capacity;
+	// Zeroed so the padding in snapshots is always the same
+	memset((void*)sim, 0, sizeof(Simulation));
+	sim->random_state = seed != 0 ? seed : 1; // xorshift gets stuck on 0
+	data->rectangle_shader = 0;
+	data->circle_shader = 0;
+	data->quad_vao = 0;
+	data->rewind_buffer = NULL;
+	data->tile_changes.generation = 0;
+	all_tiles_changed(&data->tile_changes);
+	data->load_state = ASSETS_READY;
+	data->loading = NULL;
+	data->collision_limit_hit = false;
 
 	//
-	// OpenGL set up
+	// Set up tiles
 	//
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	set_grid_level(sim, grid_size);
+	data->kernels = select_grid_kernels(sim);
 
 	//
-	// Set up rectangle shader
+	// Reset Game
 	//
-	char* rectangle_vert_shader = load_file("shaders/rectangle.vs");
-	char* rectangle_frag_shader = load_file("shaders/rectangle.fs");
-	if (rectangle_vert_shader == NULL || rectangle_frag_shader == NULL) {
-		return NULL;
-	}
+	reset_game(sim);
+	sim->state = PAUSED;
+}
+
+/**
+ * Allocate memory for count simulations of tile_capacity tiles, one after the other (remember to call free_simulations() after)
+ */
+Simulation* allocate_simulations(int32 count, int32 tile_capacity) {
+	return (Simulation*)::operator new((size_t)count * simulation_stride(tile_capacity), std::align_val_t(alignof(Simulation)));
+}
 
-	data->rectangle_shader = create_shader_program(rectangle_vert_shader, rectangle_frag_shader);
+void free_simulations(Simulation* sims) {
+	::operator delete(sims, std::align_val_t(alignof(Simulation)));
+}
 
-	free_file(rectangle_vert_shader);
-	free_file(rectangle_frag_shader);
+Data* Game::init_headless(Vec2Int grid_size) {
+	int32 tile_capacity = grid_size.x * grid_size.y;
+	Data* data = new Data;
+	init_data(data, allocate_simulations(1, tile_capacity), tile_capacity, grid_size, 1);
+	return data;
+}
 
-	if (data->rectangle_shader == 0) {
-		std::cout << "Failed to create rect shader program." << std::endl;
-		return NULL;
+void Game::free_headless(Data* data) {
+	free_simulations(data->sim);
+	delete data;
+}
+
+/**
+ * Grid of the built-in level of a game with a window, (0, 0) picks the default grid
+ */
+Vec2Int game_grid_size(Vec2Int grid_size) {
+	return grid_size.x > 0 && grid_size.y > 0 ? grid_size : default_tile_grid_size;
+}
+
+/**
+ * Tiles a game with a window makes room for, at least the built-in level
+ */
+int32 game_tile_capacity(Vec2Int grid_size, int32 tile_capacity) {
+	int32 grid_tile_count = grid_size.x * grid_size.y;
+	return tile_capacity > grid_tile_count ? tile_capacity : grid_tile_count;
+}
+
+uint64 Game::init_memory_size(Vec2Int grid_size, int32 tile_capacity) {
+	tile_capacity = game_tile_capacity(game_grid_size(grid_size), tile_capacity);
+
+	// Every push can be padded up to the default alignment
+	return sizeof(Data) + sizeof(AssetLoading) + simulation_size(tile_capacity) 
+			+ rewind_buffer_memory_size(rewind_frame_count, tile_capacity) + 7 * arena_default_alignment;
+}
+
+/**
+ * Report a finished phase of init() to the platform layer's startup trace
+ */
+void mark_startup_phase(const Input* input, const char* phase) {
+	if (input->trace_startup != NULL) {
+		input->trace_startup(phase);
 	}
+}
+
+Data* Game::init(const Input* input) {
 
 	//
-	// Set up circle shader
+	// Start loading the shaders in the background, render() builds the programs
+	// once they arrive and shows a loading screen until then
 	//
-	char* circle_vert_shader = load_file("shaders/circle.vs");
-	char* circle_frag_shader = load_file("shaders/circle.fs");
-	if (circle_vert_shader == NULL || circle_frag_shader == NULL) {
+	AssetLoading* loading = arena_push_array<AssetLoading>(input->permanent_arena, 1);
+	if (loading == NULL) {
+		return NULL;
+	}
+	memset(loading, 0, sizeof(AssetLoading));
+
+	loading->parallel_shader_compile = enable_parallel_shader_compile(input->get_gl_proc_address);
+	init_shader_cache(&loading->shader_cache, input->shader_cache_directory, input->get_gl_proc_address, input->frame_arena);
+	mark_startup_phase(input, "Shader cache setup");
+
+	Vec2Int grid_size = game_grid_size(input->grid_size);
+	int32 tile_capacity = game_tile_capacity(grid_size, input->tile_capacity);
+	Data* data = arena_push_array<Data>(input->permanent_arena, 1);
+	Simulation* sim = (Simulation*)arena_push(input->permanent_arena, simulation_size(tile_capacity));
+	RewindBuffer* rewind_buffer = push_rewind_buffer(input->permanent_arena, rewind_frame_count, tile_capacity);
+	if (data == NULL || sim == NULL || rewind_buffer == NULL) {
 		return NULL;
 	}
+	mark_startup_phase(input, "Game memory and rewind buffer");
 
-	data->circle_shader = create_shader_program(circle_vert_shader, circle_frag_shader);
+	loading->loader = start_asset_loader(input->assets, shader_asset_names, SHADER_ASSET_COUNT);
+	mark_startup_phase(input, "Start asset loader");
 
-	free_file(circle_vert_shader);
-	free_file(circle_frag_shader);
+	//
+	// Initialize game data
+	//
+	new (data) Data;
+	init_data(data, sim, tile_capacity, grid_size, 1);
+	data->load_state = ASSETS_LOADING;
+	data->loading = loading;
+	mark_startup_phase(input, "Game data and tile layout");
 
-	if (data->circle_shader == 0) {
-		std::cout << "Failed to create circle shader program." << std::endl;
-		return NULL;
-	}
+	data->rewind_buffer = rewind_buffer;
+
+	//
+	// OpenGL set up
+	//
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	//
 	// Set up quad vao
@@ -179,93 +496,149 @@ Data* Game::init(const Input* input) {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-	//
-	// Set up tile positions
-	//
-	{
-		// Start at upper left tile
-		Vec2 cur_pos;
-		cur_pos.y = (world_size.y * 0.5f) - (tile_size.y * 0.5f) + tile_grid_offset.y;
-		for (int y = 0; y < tile_grid_size.y; y++) {
-			cur_pos.x = -(tile_size.x * tile_grid_size.x * 0.5f) + (tile_size.x * 0.5f) + tile_grid_offset.x;
-			for (int x = 0; x < tile_grid_size.x; x++) {
-				Tile* tile = &data->tiles[x + y * tile_grid_size.x];
-				tile->pos = cur_pos;
-				cur_pos.x += tile_size.x;
-			}
-			cur_pos.y -= tile_size.y;
-		}
-	}
-
-	//
-	// Reset Game
-	//
-	reset_game(data);
-	data->state = PAUSED;
+	mark_startup_phase(input, "Quad VAO");
 
 	std::cout << "Game Initialized" << std::endl;
 	return data;
 }
 
-void Game::update(const Input* input, Data* data) {
+void Game::observe(const Data* data, Observation* observation) {
+	const Simulation* sim = data->sim;
 
-	//
-	// Handle state logic
-	//
-	if (data->state == PAUSED) {
-		if (input->start_key_pressed && !input->start_key_pressed_prev) {
-			data->state = PLAYING;
-		} else {
-			return;
-		}
-	} else if (data->state == GAME_OVER) {
-		if (input->start_key_pressed && !input->start_key_pressed_prev) {
-			reset_game(data);
-			data->state = PLAYING;
-		} else {
-			return;
-		}
-	} else if (data->state == PLAYING) {
-		if (input->start_key_pressed && !input->start_key_pressed_prev) {
-			data->state = PAUSED;
-			return;
+	observation->state = sim->state;
+	observation->score = sim->score;
+	observation->level = sim->level;
+	observation->lives = sim->lives;
+
+	observation->paddle_pos_x = sim->paddle_pos_x;
+	observation->ball_pos = sim->ball_pos;
+	observation->ball_vel = sim->ball_vel;
+
+	const Tile* tiles = simulation_tiles(sim);
+	int32 count = sim->tile_count < observation_tile_capacity ? sim->tile_count : observation_tile_capacity;
+	observation->tile_count = count;
+	for (int i = 0; i < count; i++) {
+		observation->tile_health[i] = tiles[i].health;
+	}
+}
+
+/**
+ * Find the tiles a ball moving from p1 to p2 can touch, as a range of grid cells. Cell (x, y) is
+ * tile x + y * row_length, levels with free positions are a single row of every tile.
+ * The range is empty (min > max) if the ball can't reach any tile.
+ * @param GridX, GridY Size of the grid if it's known at compile time (see GridKernels), 0 to read it from the simulation
+ */
+template<int32 GridX, int32 GridY>
+void tiles_in_reach(const Simulation* sim, Vec2 p1, Vec2 p2, Vec2Int* min_cell, Vec2Int* max_cell, int32* row_length) {
+	const bool fixed_grid = GridX > 0 && GridY > 0;
+	if (!fixed_grid && sim->free_positions) {
+		*min_cell = Vec2Int(0, 0);
+		*max_cell = Vec2Int(sim->tile_count - 1, 0);
+		*row_length = sim->tile_count;
+		return;
+	}
+	const Vec2Int grid_size = fixed_grid ? Vec2Int(GridX, GridY) : sim->grid_size;
+
+	// Columns count right from the left edge of the grid and rows count down from the top,
+	// grown by a cell so rounding never leaves out a tile the ball touches
+	Vec2 top_left = grid_top_left(grid_size, sim->tile_size);
+	float32 column_min = floor((fmin(p1.x, p2.x) - ball_radius - top_left.x) / sim->tile_size.x) - 1.0f;
+	float32 column_max = floor((fmax(p1.x, p2.x) + ball_radius - top_left.x) / sim->tile_size.x) + 1.0f;
+	float32 row_min = floor((top_left.y - fmax(p1.y, p2.y) - ball_radius) / sim->tile_size.y) - 1.0f;
+	float32 row_max = floor((top_left.y - fmin(p1.y, p2.y) + ball_radius) / sim->tile_size.y) + 1.0f;
+
+	// Clamped on both sides, far away paths would overflow the conversion
+	min_cell->x = (int32)fmin(fmax(0.0f, column_min), (float32)grid_size.x);
+	max_cell->x = (int32)fmax(fmin(grid_size.x - 1.0f, column_max), -1.0f);
+	min_cell->y = (int32)fmin(fmax(0.0f, row_min), (float32)grid_size.y);
+	max_cell->y = (int32)fmax(fmin(grid_size.y - 1.0f, row_max), -1.0f);
+	*row_length = grid_size.x;
+}
+
+/**
+ * Find the closest live tile the ball moving from p1 to p2 hits, if it's closer than closest_distance
+ * @param GridX, GridY Size of the grid if it's known at compile time (see GridKernels), 0 to read it from the simulation
+ * @returns The tile hit or NULL, closest_distance, closest_point and closest_normal are only written if a tile was hit
+ */
+template<int32 GridX, int32 GridY>
+Tile* tile_collision(Simulation* sim, Vec2 p1, Vec2 p2, float32* closest_distance, Vec2* closest_point, Vec2* closest_normal, 
+		PhysicsCounters* counters)
+{
+	Tile* tiles = simulation_tiles(sim);
+	Tile* hit_tile = NULL;
+	float32 distance;
+	Vec2 point, normal;
+
+	// Only the tiles within reach of the ball on grid levels
+	Vec2Int min_cell, max_cell;
+	int32 row_length;
+	tiles_in_reach<GridX, GridY>(sim, p1, p2, &min_cell, &max_cell, &row_length);
+	for (int y = min_cell.y; y <= max_cell.y; y++) {
+		for (int x = min_cell.x; x <= max_cell.x; x++) {
+			Tile* tile = &tiles[y * row_length + x];
+			if (tile->health < 1) {
+				continue;
+			}
+
+			if (!moving_circle_to_retangle_collision_quick_check(p1, p2, ball_radius, tile->pos, sim->tile_size)) {
+				counters->values[PHYSICS_BROADPHASE_REJECTIONS]++;
+				continue;
+			}
+
+			counters->values[PHYSICS_NARROWPHASE_TESTS]++;
+			if (moving_circle_to_retangle_collision_narrow_check(p1, p2, ball_radius, tile->pos, sim->tile_size, 
+				&distance, &point, &normal) && distance < *closest_distance) 
+			{
+				*closest_distance = distance;
+				*closest_point = point;
+				*closest_normal = normal;
+				hit_tile = tile;
+			}
 		}
 	}
+	return hit_tile;
+}
+
+/**
+ * Step the paddle, ball and tiles while the game is being played
+ * @param GridX, GridY Size of the grid if it's known at compile time (see GridKernels), 0 to read it from the simulation
+ * @param direction -1 to move the paddle left, 1 to move it right, 0 to stay still
+ * @param changes The tiles changed are added to this if it isn't NULL
+ * @returns True if the ball hit the max collision iterations and stopped short
+ */
+template<int32 GridX, int32 GridY>
+bool simulate(Simulation* sim, float64 delta_time, int32 direction, TileChanges* changes) {
+	bool collision_limit_hit = false;
+	int32 level = sim->level;
+
+	PhysicsCounters counters = {};
+	counters.values[PHYSICS_FRAMES] = 1;
 
 	//
 	// Paddle Movement
 	//
 	{
-		int32 direction = 0;
+		PROFILE_SCOPE("Paddle");
 
-		if (input->left_key_pressed) {
-			direction -= 1;
-		}
-
-		if (input->right_key_pressed) {
-			direction += 1;
-		}
-
-		Vec2 delta = Vec2(direction * paddle_speed * (float32)input->delta_time, 0.0f);
+		Vec2 delta = Vec2(direction * paddle_speed * (float32)delta_time, 0.0f);
 
 		// Prevent movement if we would collide with the ball
 		// @refactor: The check moves the ball in the opposite direction that the paddle is moving
 		// to check for the collision. Not ideal but works for now.
 		float32 distance;
 		Vec2 point, normal;
-		const Vec2 paddle_pos = Vec2(data->paddle_pos_x, paddle_pos_y);
-		if (!moving_circle_to_retangle_collision_check(data->ball_pos, data->ball_pos - delta, ball_radius, paddle_pos, paddle_size, 
+		const Vec2 paddle_pos = Vec2(sim->paddle_pos_x, paddle_pos_y);
+		if (!moving_circle_to_retangle_collision_check(sim->ball_pos, sim->ball_pos - delta, ball_radius, paddle_pos, paddle_size, 
 				&distance, &point, &normal))
 		{
-			data->paddle_pos_x += delta.x;
+			sim->paddle_pos_x += delta.x;
 		}
 		
 		float32 max_pos_x = (world_size.x * 0.5f);
-		if (data->paddle_pos_x > max_pos_x) {
-			data->paddle_pos_x = max_pos_x;
-		} else if (data->paddle_pos_x < -max_pos_x) {
-			data->paddle_pos_x = -max_pos_x;
+		if (sim->paddle_pos_x > max_pos_x) {
+			sim->paddle_pos_x = max_pos_x;
+		} else if (sim->paddle_pos_x < -max_pos_x) {
+			sim->paddle_pos_x = -max_pos_x;
 		}
 	}
 
@@ -274,8 +647,10 @@ void Game::update(const Input* input, Data* data) {
 	//
 	// @cleanup: The logic here for the collision checking could be cleaner
 	{
-		Vec2 old_ball_pos = data->ball_pos;
-		Vec2 new_ball_pos = data->ball_pos + (data->ball_vel * input->delta_time);
+		PROFILE_SCOPE("Ball Collision");
+
+		Vec2 old_ball_pos = sim->ball_pos;
+		Vec2 new_ball_pos = sim->ball_pos + (sim->ball_vel * delta_time);
 
 		Vec2 delta = new_ball_pos - old_ball_pos;
 		float32 remaining_distance = magnitude(delta);
@@ -284,9 +659,11 @@ void Game::update(const Input* input, Data* data) {
 		while (remaining_distance > 0) {
 			iteration++;
 			if (iteration >= 5) {
-				std::cout << "Warning: Hit max collision iterations." << std::endl;
+				collision_limit_hit = true;
+				counters.values[PHYSICS_COLLISION_LIMIT_HITS]++;
 				break;
 			}
+			counters.values[PHYSICS_COLLISION_ITERATIONS]++;
 
 			float32 closest_distance = INFINITY;
 			Vec2 closest_point, closest_normal;
@@ -323,53 +700,51 @@ void Game::update(const Input* input, Data* data) {
 
 			// Paddle collision
 			bool hit_paddle = false;
-			const Vec2 paddle_pos = Vec2(data->paddle_pos_x, paddle_pos_y);
-			if (moving_circle_to_retangle_collision_check(old_ball_pos, new_ball_pos, ball_radius, paddle_pos, paddle_size, 
-					&distance, &point, &normal) && distance < closest_distance) 
-			{
-				closest_distance = distance;
-				closest_point = point;
-				closest_normal = normal;
-				hit_paddle = true;
-			}
-
-			// Tile collision
-			Tile* hit_tile = NULL;
-			for (int i = 0; i < tile_count; i++) {
-				Tile* tile = &data->tiles[i];
-				if (tile->health < 1) {
-					continue;
-				}
-
-				if (moving_circle_to_retangle_collision_check(old_ball_pos, new_ball_pos, ball_radius, tile->pos, tile_size, 
-					&distance, &point, &normal) && distance < closest_distance) 
+			const Vec2 paddle_pos = Vec2(sim->paddle_pos_x, paddle_pos_y);
+			if (!moving_circle_to_retangle_collision_quick_check(old_ball_pos, new_ball_pos, ball_radius, paddle_pos, paddle_size)) {
+				counters.values[PHYSICS_BROADPHASE_REJECTIONS]++;
+			} else {
+				counters.values[PHYSICS_NARROWPHASE_TESTS]++;
+				if (moving_circle_to_retangle_collision_narrow_check(old_ball_pos, new_ball_pos, ball_radius, paddle_pos, paddle_size, 
+						&distance, &point, &normal) && distance < closest_distance) 
 				{
 					closest_distance = distance;
 					closest_point = point;
 					closest_normal = normal;
-					hit_tile = tile;
-					hit_paddle = false;
+					hit_paddle = true;
 				}
 			}
 
+			// Tile collision
+			Tile* hit_tile = tile_collision<GridX, GridY>(sim, old_ball_pos, new_ball_pos, 
+				&closest_distance, &closest_point, &closest_normal, &counters);
+			if (hit_tile != NULL) {
+				hit_paddle = false;
+			}
+
 			// Check closest collision
 			if (closest_distance < remaining_distance) {
 				remaining_distance -= closest_distance;
-				data->ball_vel = reflect(data->ball_vel, closest_normal);
+				sim->ball_vel = reflect(sim->ball_vel, closest_normal);
 				
 				// Add extra rotation if hitting the paddle based on how far the hit was from the center
 				if (hit_paddle && closest_normal.y > 0.99f) {
 					float32 rotation = ((paddle_pos.x - point.x) / paddle_size.x) * 2.0f * ball_paddle_max_rotation;
-					data->ball_vel = rotate(data->ball_vel, rotation);
+					sim->ball_vel = rotate(sim->ball_vel, rotation);
 				}
 
-				if (hit_tile != NULL) {
+				if (hit_tile != NULL && hit_tile->type == TILE_NORMAL) {
 					hit_tile->health--;
-					data->score++;
+					tile_changed(changes, (int32)(hit_tile - simulation_tiles(sim)));
+					sim->score++;
+					if (hit_tile->health < 1) {
+						sim->tiles_left--;
+						counters.values[PHYSICS_TILES_DESTROYED]++;
+					}
 				}
 				
 				old_ball_pos = closest_point;
-				new_ball_pos = closest_point + normalize(data->ball_vel) * remaining_distance;
+				new_ball_pos = closest_point + normalize(sim->ball_vel) * remaining_distance;
 				delta = new_ball_pos - old_ball_pos;
 			} else {
 				remaining_distance = 0.0f;
@@ -377,29 +752,22 @@ void Game::update(const Input* input, Data* data) {
 		}
 
 		// Update ball pos
-		data->ball_pos = new_ball_pos;
+		sim->ball_pos = new_ball_pos;
 	}
 
 	//
 	// Check Advance Level
 	//
 	{
-		bool has_health = false;
-		for (int i = 0; i < tile_count; i++) {
-			if (data->tiles[i].health > 0) {
-				has_health = true;
-				break;
-			}
-		}
+		PROFILE_SCOPE("Level Check");
 
-		if (!has_health) {
-			data->level++;
-			reset_ball_and_paddle(data, ball_base_speed + ball_level_speed * (data->level - 1));
-			for (int i = 0; i < tile_count; i++) {
-				data->tiles[i].health = data->level;
-			}
+		if (sim->tiles_left < 1) {
+			sim->level++;
+			reset_ball_and_paddle(sim, ball_base_speed + ball_level_speed * (sim->level - 1));
+			refill_tiles(sim);
+			all_tiles_changed(changes);
 			
-			data->state = PAUSED;
+			sim->state = PAUSED;
 		}
 	}
 
@@ -407,42 +775,957 @@ void Game::update(const Input* input, Data* data) {
 	// Check Game Over
 	//
 	{
-		if (data->ball_pos.y < -world_size.y * 0.5f) {
-			if (data->lives > 0) {
-				data->lives--;
-				reset_ball_and_paddle(data, ball_base_speed + ball_level_speed * (data->level - 1));
-				data->state = PAUSED;
+		if (sim->ball_pos.y < -world_size.y * 0.5f) {
+			if (sim->lives > 0) {
+				sim->lives--;
+				reset_ball_and_paddle(sim, ball_base_speed + ball_level_speed * (sim->level - 1));
+				sim->state = PAUSED;
 			} else {
-				data->state = GAME_OVER;
+				sim->state = GAME_OVER;
 			}
 		}
 	}
+
+	physics_metrics_add(level, &counters);
+	return collision_limit_hit;
 }
 
-void Game::render(const Input* input, Data* data) {
+//
+// Trajectory Prediction
+//
 
-	//
-	// Update window title
-	//
-	switch (data->state) {
-		case PAUSED:
-			input->update_ui(data->score, data->lives, "Press Spacebar to Play");
-			break;
-		case PLAYING:
-			input->update_ui(data->score, data->lives, NULL);
-			break;
-		case GAME_OVER:
-			input->update_ui(data->score, data->lives, "Press Spacebar to Play Again");
-			break;
-	}
+/**
+ * Tiles hit earlier in a prediction, so later bounces go through the tiles it already destroyed
+ */
+struct TrajectoryDamage {
+	int32 count;
+	int32 tiles[trajectory_max_bounces];
+	int32 health[trajectory_max_bounces]; // Predicted health left
+};
 
-	const float world_to_clip[9] = { 
-		2.0f / world_size.x, 0.0f,                0.0f,
-		0.0f,                2.0f / world_size.y, 0.0f,
-		0.0f,                0.0f,                1.0f
-	};
+int32 predicted_tile_health(const Simulation* sim, const TrajectoryDamage* damage, int32 index) {
+	for (int i = 0; i < damage->count; i++) {
+		if (damage->tiles[i] == index) {
+			return damage->health[i];
+		}
+	}
+	return simulation_tiles(sim)[index].health;
+}
 
-	glViewport(0, 0, input->frame_buffer_size.x, input->frame_buffer_size.y);
+void damage_predicted_tile(const Simulation* sim, TrajectoryDamage* damage, int32 index) {
+	if (simulation_tiles(sim)[index].type != TILE_NORMAL) {
+		return;
+	}
+
+	for (int i = 0; i < damage->count; i++) {
+		if (damage->tiles[i] == index) {
+			damage->health[i]--;
+			return;
+		}
+	}
+
+	// There is at most one hit per bounce so this always has room
+	if (damage->count < trajectory_max_bounces) {
+		damage->tiles[damage->count] = index;
+		damage->health[damage->count] = simulation_tiles(sim)[index].health - 1;
+		damage->count++;
+	}
+}
+
+/**
+ * Find the closest live tile hit by the ball moving from p1 to p2
+ * @param GridX, GridY Size of the grid if it's known at compile time (see GridKernels), 0 to read it from the simulation
+ * @returns Index of the tile or -1 if none was hit
+ */
+template<int32 GridX, int32 GridY>
+int32 trajectory_tile_check(const Simulation* sim, const TrajectoryDamage* damage, Vec2 p1, Vec2 p2, float32 closest_distance, 
+		float32* distance, Vec2* point, Vec2* normal)
+{
+	const bool fixed_grid = GridX > 0 && GridY > 0;
+	const Tile* tiles = simulation_tiles(sim);
+	Vec2 delta = p2 - p1;
+	Vec2 top_left = grid_top_left(fixed_grid ? Vec2Int(GridX, GridY) : sim->grid_size, sim->tile_size);
+
+	Vec2Int min_cell, max_cell;
+	int32 row_length;
+	tiles_in_reach<GridX, GridY>(sim, p1, p2, &min_cell, &max_cell, &row_length);
+
+	int32 hit_index = -1;
+	for (int32 y = min_cell.y; y <= max_cell.y; y++) {
+		// The path is long, so on grid levels only test the columns the part of it within reach of the row crosses
+		Vec2Int row_min_cell = min_cell;
+		Vec2Int row_max_cell = max_cell;
+		if (fixed_grid || !sim->free_positions) {
+			float32 band_top = top_left.y - sim->tile_size.y * y + ball_radius;
+			float32 band_bottom = band_top - sim->tile_size.y - ball_radius * 2.0f;
+			float32 t_min = 0.0f;
+			float32 t_max = 1.0f;
+			if (delta.y != 0.0f) {
+				float32 t_a = (band_bottom - p1.y) / delta.y;
+				float32 t_b = (band_top - p1.y) / delta.y;
+				t_min = fmax(t_min, fmin(t_a, t_b));
+				t_max = fmin(t_max, fmax(t_a, t_b));
+			} else if (p1.y < band_bottom || p1.y > band_top) {
+				continue;
+			}
+			if (t_min > t_max) {
+				continue;
+			}
+			tiles_in_reach<GridX, GridY>(sim, p1 + delta * t_min, p1 + delta * t_max, &row_min_cell, &row_max_cell, &row_length);
+		}
+
+		for (int32 x = row_min_cell.x; x <= row_max_cell.x; x++) {
+			int32 index = y * row_length + x;
+			if (predicted_tile_health(sim, damage, index) < 1) {
+				continue;
+			}
+
+			float32 tile_distance;
+			Vec2 tile_point, tile_normal;
+			if (moving_circle_to_retangle_collision_check(p1, p2, ball_radius, tiles[index].pos, sim->tile_size, 
+					&tile_distance, &tile_point, &tile_normal) && tile_distance < closest_distance)
+			{
+				closest_distance = tile_distance;
+				*distance = tile_distance;
+				*point = tile_point;
+				*normal = tile_normal;
+				hit_index = index;
+			}
+		}
+	}
+	return hit_index;
+}
+
+/**
+ * Draw the live tiles, the rectangle program with the tile scale is already bound
+ * @param GridX, GridY Size of the grid if it's known at compile time (see GridKernels), 0 to read it from the simulation
+ */
+template<int32 GridX, int32 GridY>
+void render_tiles(const Simulation* sim, int center_pos_location, int alpha_location) {
+	// Alphas are worked out a chunk of tiles at a time in a loop without draw calls so it vectorizes, 
+	// grids known at compile time are a single chunk with a fixed trip count
+	const int32 fixed_tile_count = GridX * GridY;
+	const int32 chunk_size = fixed_tile_count > 0 ? fixed_tile_count : 64;
+	const int32 tile_count = fixed_tile_count > 0 ? fixed_tile_count : sim->tile_count;
+	const Tile* tiles = simulation_tiles(sim);
+
+	float32 alphas[chunk_size];
+	for (int32 first = 0; first < tile_count; first += chunk_size) {
+		const int32 count = fixed_tile_count > 0 ? fixed_tile_count : (tile_count - first < chunk_size ? tile_count - first : chunk_size);
+		const Tile* chunk = tiles + first;
+
+		// Indestructible tiles are always drawn solid, destroyed tiles get a negative alpha and aren't drawn
+		for (int i = 0; i < count; i++) {
+			float32 alpha = (float32)chunk[i].health / (float32)(chunk[i].base_health * sim->level);
+			alpha = chunk[i].type == TILE_NORMAL ? alpha : 1.0f;
+			alphas[i] = chunk[i].health > 0 ? alpha : -1.0f;
+		}
+
+		for (int i = 0; i < count; i++) {
+			if (alphas[i] < 0.0f) {
+				continue;
+			}
+			glUniform2f(center_pos_location, chunk[i].pos.x, chunk[i].pos.y);
+			glUniform1f(alpha_location, alphas[i]);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		}
+	}
+}
+
+typedef bool  (*SimulateKernel)(Simulation* sim, float64 delta_time, int32 direction, TileChanges* changes);
+typedef int32 (*TrajectoryTileKernel)(const Simulation* sim, const TrajectoryDamage* damage, Vec2 p1, Vec2 p2, float32 closest_distance, 
+		float32* distance, Vec2* point, Vec2* normal);
+typedef void  (*RenderTilesKernel)(const Simulation* sim, int center_pos_location, int alpha_location);
+
+/**
+ * The loops over the tiles built for one grid size, so the compiler knows the
+ * trip counts and can unroll and vectorize them. Each game points at the kernels 
+ * for its current level (see select_grid_kernels()).
+ */
+struct GridKernels {
+	int32 grid_size_x; // 0 for the kernels that read the grid size from the simulation
+	int32 grid_size_y;
+
+	SimulateKernel       simulate;
+	TrajectoryTileKernel trajectory_tile_check;
+	RenderTilesKernel    render_tiles;
+};
+
+#define GRID_KERNELS(x, y) { x, y, simulate<x, y>, trajectory_tile_check<x, y>, render_tiles<x, y> }
+
+// Grids played often enough to build kernels for, ending with the kernels for every other level
+const GridKernels grid_kernels[] = {
+	GRID_KERNELS(default_grid_size_x, default_grid_size_y),
+	GRID_KERNELS(0, 0)
+};
+
+#undef GRID_KERNELS
+
+/**
+ * Pick the kernels for the level a simulation is on, levels with free positions 
+ * and grids without kernels of their own get the ones that read the size at runtime
+ */
+const GridKernels* select_grid_kernels(const Simulation* sim) {
+	const int32 count = sizeof(grid_kernels) / sizeof(grid_kernels[0]);
+	for (int i = 0; i < count - 1; i++) {
+		if (!sim->free_positions && sim->grid_size.x == grid_kernels[i].grid_size_x && sim->grid_size.y == grid_kernels[i].grid_size_y) {
+			return &grid_kernels[i];
+		}
+	}
+	return &grid_kernels[count - 1];
+}
+
+void Game::predict_trajectory(const Data* data, int32 bounce_count, Trajectory* trajectory) {
+	const Simulation* sim = data->sim;
+	if (bounce_count > trajectory_max_bounces) {
+		bounce_count = trajectory_max_bounces;
+	}
+
+	TrajectoryDamage damage;
+	damage.count = 0;
+
+	// Long enough to reach a wall from anywhere in the world
+	const float32 segment_length = world_size.x + world_size.y;
+	const Vec2 paddle_pos = Vec2(sim->paddle_pos_x, paddle_pos_y);
+
+	Vec2 pos = sim->ball_pos;
+	Vec2 vel = sim->ball_vel;
+
+	trajectory->point_count = 0;
+	trajectory->ball_lost = false;
+	trajectory->points[trajectory->point_count++] = pos;
+
+	for (int bounce = 0; bounce < bounce_count; bounce++) {
+		Vec2 direction = normalize(vel);
+		Vec2 end = pos + direction * segment_length;
+
+		float32 closest_distance = INFINITY;
+		Vec2 closest_point, closest_normal;
+
+		float32 distance;
+		Vec2 point, normal;
+
+		if (moving_circle_to_vertical_line_collision_check(pos, end, ball_radius, world_size.x * 0.5f, 
+				&distance, &point, &normal) && distance < closest_distance)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+		}
+
+		if (moving_circle_to_vertical_line_collision_check(pos, end, ball_radius, -world_size.x * 0.5f, 
+				&distance, &point, &normal) && distance < closest_distance)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+		}
+
+		if (moving_circle_to_horizontal_line_collision_check(pos, end, ball_radius, world_size.y * 0.5f, 
+				&distance, &point, &normal) && distance < closest_distance)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+		}
+
+		bool hit_paddle = false;
+		if (moving_circle_to_retangle_collision_check(pos, end, ball_radius, paddle_pos, paddle_size, 
+				&distance, &point, &normal) && distance < closest_distance) 
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+			hit_paddle = true;
+		}
+
+		int32 hit_tile = data->kernels->trajectory_tile_check(sim, &damage, pos, end, closest_distance, &distance, &point, &normal);
+		if (hit_tile >= 0) {
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+			hit_paddle = false;
+		}
+
+		if (closest_distance == INFINITY) {
+			// Nothing in the way, the ball leaves through the bottom of the world
+			float32 floor_y = -world_size.y * 0.5f;
+			if (direction.y < 0.0f) {
+				trajectory->points[trajectory->point_count++] = pos + direction * ((floor_y - pos.y) / direction.y);
+			}
+			trajectory->ball_lost = true;
+			return;
+		}
+
+		vel = reflect(vel, closest_normal);
+		if (hit_paddle && closest_normal.y > 0.99f) {
+			float32 rotation = ((paddle_pos.x - closest_point.x) / paddle_size.x) * 2.0f * ball_paddle_max_rotation;
+			vel = rotate(vel, rotation);
+		}
+
+		if (hit_tile >= 0) {
+			damage_predicted_tile(sim, &damage, hit_tile);
+		}
+
+		pos = closest_point;
+		trajectory->points[trajectory->point_count++] = pos;
+	}
+}
+
+void Game::update(const Input* input, Data* data) {
+	PROFILE_SCOPE("Update");
+	ASSERT_NO_ALLOCATIONS("Game::update");
+
+	// Nothing is shown yet, so hold the game still
+	if (data->load_state != ASSETS_READY) {
+		return;
+	}
+
+	Simulation* sim = data->sim;
+	data->collision_limit_hit = false;
+
+	//
+	// Rewind while the key is held, the game is paused after so the player can continue when ready
+	//
+	if (data->rewind_buffer != NULL && input->rewind_key_pressed) {
+		rewind(data->rewind_buffer, data, 1);
+		sim->state = PAUSED;
+		return;
+	}
+
+	//
+	// Handle state logic
+	//
+	if (sim->state == PAUSED) {
+		if (input->start_key_pressed && !input->start_key_pressed_prev) {
+			sim->state = PLAYING;
+		} else {
+			return;
+		}
+	} else if (sim->state == GAME_OVER) {
+		if (input->start_key_pressed && !input->start_key_pressed_prev) {
+			reset_game(sim);
+			all_tiles_changed(&data->tile_changes);
+			sim->state = PLAYING;
+		} else {
+			return;
+		}
+	} else if (sim->state == PLAYING) {
+		if (input->start_key_pressed && !input->start_key_pressed_prev) {
+			sim->state = PAUSED;
+			return;
+		}
+	}
+
+	//
+	// Simulate the frame
+	//
+	int32 direction = 0;
+
+	if (input->left_key_pressed) {
+		direction -= 1;
+	}
+
+	if (input->right_key_pressed) {
+		direction += 1;
+	}
+
+	data->collision_limit_hit = data->kernels->simulate(sim, input->delta_time, direction, &data->tile_changes);
+
+	// The changes start over from the frame just recorded, without a buffer they just pile up until every tile counts
+	if (data->rewind_buffer != NULL) {
+		record_frame(data->rewind_buffer, data);
+		data->tile_changes.generation = data->rewind_buffer->generation;
+		data->tile_changes.count = 0;
+	}
+}
+
+bool Game::collision_limit_hit(const Data* data) {
+	return data->collision_limit_hit;
+}
+
+LoadState Game::load_state(const Data* data) {
+	return data->load_state;
+}
+
+void Game::start_level(Data* data, int32 level) {
+	Simulation* sim = data->sim;
+	sim->level = level > 0 ? level : 1;
+	reset_ball_and_paddle(sim, ball_base_speed + ball_level_speed * (sim->level - 1));
+	refill_tiles(sim);
+	all_tiles_changed(&data->tile_changes);
+	sim->state = PAUSED;
+}
+
+bool Game::load_level(Data* data, const Level* level) {
+	const LevelHeader* header = level->header;
+	if (header->tile_count > data->tile_capacity) {
+		std::cout << "Level has " << header->tile_count << " tiles but the game only has room for "
+				<< data->tile_capacity << std::endl;
+		return false;
+	}
+
+	// The tiles are stored the same way in the file, so the level is copied in as is
+	Simulation* sim = data->sim;
+	sim->tile_count = header->tile_count;
+	sim->grid_size = Vec2Int(header->grid_size_x, header->grid_size_y);
+	sim->tile_size = Vec2(header->tile_size_x, header->tile_size_y);
+	sim->free_positions = (header->flags & LEVEL_FREE_POSITIONS) != 0;
+	memcpy(simulation_tiles(sim), level->tiles, (size_t)header->tile_count * sizeof(Tile));
+	data->kernels = select_grid_kernels(sim);
+	all_tiles_changed(&data->tile_changes);
+
+	reset_game(sim);
+	sim->state = PAUSED;
+	return true;
+}
+
+int32 Game::snapshot_size(const Data* data) {
+	return simulation_size(data->sim->tile_count);
+}
+
+void Game::save_snapshot(const Data* data, void* snapshot) {
+	memcpy(snapshot, data->sim, simulation_size(data->sim->tile_count));
+}
+
+void Game::load_snapshot(Data* data, const void* snapshot) {
+	int32 snapshot_tile_count = ((const Simulation*)snapshot)->tile_count;
+	if (snapshot_tile_count > data->tile_capacity) {
+		std::cout << "Snapshot has " << snapshot_tile_count << " tiles but the game only has room for "
+				<< data->tile_capacity << std::endl;
+		return;
+	}
+	memcpy(data->sim, snapshot, simulation_size(snapshot_tile_count));
+	data->kernels = select_grid_kernels(data->sim);
+	all_tiles_changed(&data->tile_changes);
+}
+
+RewindBuffer* Game::create_rewind_buffer(int32 frame_count, int32 tile_capacity) {
+	RewindBuffer* buffer = new RewindBuffer;
+	buffer->latest = allocate_simulations(1, tile_capacity);
+	buffer->deltas = new uint8[rewind_deltas_capacity(frame_count, tile_capacity)];
+	buffer->entries = new RewindEntry[rewind_entries_capacity(frame_count)];
+	buffer->encode_buffer = new uint8[delta_max_encoded_size(simulation_size(tile_capacity))];
+	clear_rewind_buffer(buffer, frame_count, tile_capacity);
+	return buffer;
+}
+
+void Game::free_rewind_buffer(RewindBuffer* buffer) {
+	free_simulations(buffer->latest);
+	delete[] buffer->deltas;
+	delete[] buffer->entries;
+	delete[] buffer->encode_buffer;
+	delete buffer;
+}
+
+/**
+ * Drop the oldest delta in the rewind buffer
+ */
+void drop_oldest_rewind_entry(RewindBuffer* buffer) {
+	buffer->first_entry = (buffer->first_entry + 1) % buffer->entries_capacity;
+	buffer->entry_count--;
+}
+
+void Game::record_frame(RewindBuffer* buffer, const Data* data) {
+	// Deltas only work between frames of the same size, so the history starts over when another level is loaded
+	int32 sim_size = simulation_size(data->sim->tile_count);
+	if (!buffer->has_latest || sim_size != buffer->latest_size) {
+		if (data->sim->tile_count > buffer->tile_capacity) {
+			buffer->has_latest = false;
+			buffer->generation = 0;
+			return;
+		}
+		memcpy(buffer->latest, data->sim, sim_size);
+		buffer->latest_size = sim_size;
+		buffer->has_latest = true;
+		buffer->generation = next_rewind_generation();
+		buffer->first_entry = 0;
+		buffer->entry_count = 0;
+		buffer->deltas_write = 0;
+		return;
+	}
+
+	// Only the simulation and the tiles that changed are compared when few did (a quarter of the tiles at most, 
+	// which keeps the delta within the encode buffer), so big levels don't scan every tile every frame. 
+	// The delta is joined from the parts with runs of unchanged bytes. The changes are only known for the buffer 
+	// they were tracked for, any other buffer (or one another game recorded into since) compares every tile
+	const uint8* cur = (const uint8*)data->sim;
+	uint8* latest = (uint8*)buffer->latest;
+	const TileChanges* changes = &data->tile_changes;
+	bool changes_known = changes->generation == buffer->generation && changes->count >= 0;
+	buffer->generation = next_rewind_generation();
+	int32 size;
+	if (changes_known && changes->count <= data->sim->tile_count / 4 && data->sim->tile_count > 0) {
+		// Sorted so the parts are in order, a tile hit more than once is only compared once
+		int32 tiles[rewind_max_changed_tiles];
+		int32 tile_count = 0;
+		for (int i = 0; i < changes->count; i++) {
+			int32 index = changes->tiles[i];
+			int32 j = tile_count;
+			while (j > 0 && tiles[j - 1] > index) {
+				j--;
+			}
+			if (j > 0 && tiles[j - 1] == index) {
+				continue;
+			}
+			for (int k = tile_count; k > j; k--) {
+				tiles[k] = tiles[k - 1];
+			}
+			tiles[j] = index;
+			tile_count++;
+		}
+
+		uint8* out = buffer->encode_buffer;
+		out += delta_encode(cur, latest, sizeof(Simulation), out);
+		memcpy(latest, cur, sizeof(Simulation));
+		int32 position = sizeof(Simulation);
+		for (int i = 0; i < tile_count; i++) {
+			int32 offset = (int32)(sizeof(Simulation) + tiles[i] * sizeof(Tile));
+			out = delta_write_unchanged(out, offset - position);
+			out += delta_encode(cur + offset, latest + offset, sizeof(Tile), out);
+			memcpy(latest + offset, cur + offset, sizeof(Tile));
+			position = offset + sizeof(Tile);
+		}
+		out = delta_write_unchanged(out, sim_size - position);
+		size = (int32)(out - buffer->encode_buffer);
+	} else {
+		size = delta_encode(cur, latest, sim_size, buffer->encode_buffer);
+		memcpy(latest, cur, sim_size);
+	}
+
+	// Deltas are never split, wrap to the start if it doesn't fit at the end
+	int32 offset = buffer->deltas_write;
+	bool wrap = offset + size > buffer->deltas_capacity;
+	if (wrap) {
+		offset = 0;
+	}
+
+	// The oldest deltas sit just after the write position, drop them until the new delta has room
+	while (buffer->entry_count > 0) {
+		RewindEntry* oldest = &buffer->entries[buffer->first_entry];
+		bool in_skipped_end = wrap && oldest->offset >= buffer->deltas_write;
+		bool overlaps = oldest->offset < offset + size && oldest->offset + oldest->size > offset;
+		if (!in_skipped_end && !overlaps) {
+			break;
+		}
+		drop_oldest_rewind_entry(buffer);
+	}
+
+	if (buffer->entry_count == buffer->entries_capacity) {
+		drop_oldest_rewind_entry(buffer);
+	}
+
+	memcpy(buffer->deltas + offset, buffer->encode_buffer, size);
+	buffer->deltas_write = offset + size;
+
+	RewindEntry* entry = &buffer->entries[(buffer->first_entry + buffer->entry_count) % buffer->entries_capacity];
+	entry->offset = offset;
+	entry->size = size;
+	buffer->entry_count++;
+}
+
+int32 Game::recorded_frame_count(const RewindBuffer* buffer) {
+	return buffer->has_latest ? buffer->entry_count + 1 : 0;
+}
+
+bool Game::rewind(RewindBuffer* buffer, Data* data, int32 frames_back) {
+	if (frames_back < 0 || frames_back >= recorded_frame_count(buffer)) {
+		return false;
+	}
+
+	// If no tile changed since the latest frame of this buffer the game's tiles match it, so the deltas are 
+	// applied to the game as well and only the simulation is copied, instead of copying every tile
+	bool tiles_match = data->tile_changes.generation == buffer->generation && data->tile_changes.count == 0 && 
+		simulation_size(data->sim->tile_count) == buffer->latest_size;
+
+	// Step back one delta at a time from the latest frame
+	for (int i = 0; i < frames_back; i++) {
+		int32 newest = (buffer->first_entry + buffer->entry_count - 1) % buffer->entries_capacity;
+		RewindEntry* entry = &buffer->entries[newest];
+		delta_apply((uint8*)buffer->latest, buffer->latest_size, buffer->deltas + entry->offset, entry->size);
+		if (tiles_match) {
+			delta_apply((uint8*)data->sim, buffer->latest_size, buffer->deltas + entry->offset, entry->size);
+		}
+
+		buffer->deltas_write = entry->offset;
+		buffer->entry_count--;
+	}
+
+	memcpy(data->sim, buffer->latest, tiles_match ? sizeof(Simulation) : buffer->latest_size);
+	data->kernels = select_grid_kernels(data->sim);
+	buffer->generation = next_rewind_generation();
+	data->tile_changes.generation = buffer->generation;
+	data->tile_changes.count = 0;
+	return true;
+}
+
+void Game::set_rewind_buffer(Data* data, RewindBuffer* buffer) {
+	data->rewind_buffer = buffer;
+}
+
+struct AutopilotRollout {
+	int32   first_move; // -1 left, 0 stay, 1 right
+	float32 score;
+};
+
+struct Game::Autopilot {
+	ThreadPool* pool;
+
+	AutopilotRollout rollouts[autopilot_rollouts_per_move * 3];
+
+	// Every rollout simulates its own copy of the start, grown when a level with more tiles is played
+	Simulation* rollout_sims;
+	int32       rollout_sim_stride;
+	int32       tile_capacity;
+
+	// Set for the decision being made
+	Simulation*        start;
+	const GridKernels* kernels;
+	uint32      seed;
+
+	int64   decision_count;
+	float64 decision_seconds;
+};
+
+Autopilot* Game::create_autopilot(int32 thread_count) {
+	Autopilot* autopilot = new Autopilot;
+	autopilot->pool = create_thread_pool(thread_count);
+	autopilot->tile_capacity = 0;
+	autopilot->rollout_sim_stride = 0;
+	autopilot->rollout_sims = NULL;
+	autopilot->start = NULL;
+	autopilot->kernels = NULL;
+	autopilot->seed = 1;
+	autopilot->decision_count = 0;
+	autopilot->decision_seconds = 0.0;
+	return autopilot;
+}
+
+void Game::free_autopilot(Autopilot* autopilot) {
+	free_thread_pool(autopilot->pool);
+	if (autopilot->rollout_sims != NULL) {
+		free_simulations(autopilot->rollout_sims);
+	}
+	delete autopilot;
+}
+
+/**
+ * Simulate one possible future from the start state with random moves (runs on the thread pool)
+ */
+void run_autopilot_rollout(void* context, int32 index) {
+	PROFILE_SCOPE("Autopilot Rollout");
+	PROFILE_MUTE(); // Thousands of simulated frames per rollout would flood the capture
+
+	Autopilot* autopilot = (Autopilot*)context;
+	AutopilotRollout* rollout = &autopilot->rollouts[index];
+
+	const Simulation* start = autopilot->start;
+	Simulation* sim = (Simulation*)((uint8*)autopilot->rollout_sims + (int64)index * autopilot->rollout_sim_stride);
+	memcpy(sim, start, simulation_size(start->tile_count));
+	uint32 random_state = (autopilot->seed + (uint32)index * 0x9E3779B9u) | 1;
+
+	rollout->first_move = index % 3 - 1;
+	int32 move = rollout->first_move;
+	float32 score = 0.0f;
+	bool ended = false;
+
+	for (int frame = 0; frame < autopilot_horizon_frames; frame++) {
+		if (frame > 0 && frame % autopilot_move_frames == 0) {
+			move = (int32)(random_float(&random_state) * 3.0f) - 1;
+		}
+
+		autopilot->kernels->simulate(sim, autopilot_frame_time, move, NULL);
+
+		if (sim->state == GAME_OVER || sim->lives < start->lives) {
+			// Losing sooner is worse
+			score += autopilot_life_lost_score * (1.0f - (float32)frame / autopilot_horizon_frames * 0.5f);
+			ended = true;
+			break;
+		}
+
+		if (sim->state == PAUSED) {
+			score += autopilot_level_score;
+			ended = true;
+			break;
+		}
+	}
+
+	score += (float32)(sim->score - start->score);
+
+	// Prefer ending up under the ball, so the paddle is ready for futures past the horizon
+	if (!ended) {
+		score -= fabs(sim->paddle_pos_x - sim->ball_pos.x) * 0.01f;
+	}
+
+	rollout->score = score;
+}
+
+void Game::autopilot_decide(Autopilot* autopilot, const Data* data, Input* input) {
+	PROFILE_SCOPE("Autopilot Decide");
+	const int32 rollout_count = autopilot_rollouts_per_move * 3;
+
+	// The start and every rollout get a copy of the game, only reallocated when a bigger level is loaded
+	if (autopilot->rollout_sims == NULL || data->sim->tile_count > autopilot->tile_capacity) {
+		if (autopilot->rollout_sims != NULL) {
+			free_simulations(autopilot->rollout_sims);
+		}
+		autopilot->tile_capacity = data->sim->tile_count;
+		autopilot->rollout_sim_stride = simulation_stride(autopilot->tile_capacity);
+		autopilot->rollout_sims = allocate_simulations(rollout_count + 1, autopilot->tile_capacity);
+		autopilot->start = (Simulation*)((uint8*)autopilot->rollout_sims + (int64)rollout_count * autopilot->rollout_sim_stride);
+	}
+
+	ASSERT_NO_ALLOCATIONS("Game::autopilot_decide");
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+	memcpy(autopilot->start, data->sim, simulation_size(data->sim->tile_count));
+	autopilot->start->state = PLAYING;
+	autopilot->kernels = data->kernels;
+	autopilot->seed = autopilot->seed * 1664525u + 1013904223u;
+
+	run_parallel(autopilot->pool, rollout_count, run_autopilot_rollout, autopilot);
+
+	// Pick the first move with the best future, staying still wins ties
+	float32 best_scores[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (int i = 0; i < rollout_count; i++) {
+		AutopilotRollout* rollout = &autopilot->rollouts[i];
+		if (rollout->score > best_scores[rollout->first_move + 1]) {
+			best_scores[rollout->first_move + 1] = rollout->score;
+		}
+	}
+
+	int32 move = 0;
+	if (best_scores[0] > best_scores[1] && best_scores[0] >= best_scores[2]) {
+		move = -1;
+	} else if (best_scores[2] > best_scores[1] && best_scores[2] > best_scores[0]) {
+		move = 1;
+	}
+
+	input->left_key_pressed = move < 0;
+	input->right_key_pressed = move > 0;
+
+	autopilot->decision_count++;
+	autopilot->decision_seconds += std::chrono::duration<float64>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+float64 Game::autopilot_decisions_per_second(const Autopilot* autopilot) {
+	if (autopilot->decision_seconds <= 0.0) {
+		return 0.0;
+	}
+	return autopilot->decision_count / autopilot->decision_seconds;
+}
+
+int32 Game::batch_observation_size(Vec2Int grid_size) {
+	return 5 + grid_size.x * grid_size.y;
+}
+
+Data* Game::init_batch(int32 count, uint32 seed, Vec2Int grid_size) {
+	Data* batch = new Data[count];
+
+	// The simulations are stored one after the other (each starting on a cache line)
+	// so stepping the batch streams through them
+	int32 tile_count = grid_size.x * grid_size.y;
+	Simulation* sims = allocate_simulations(count, tile_count);
+	int32 stride = simulation_stride(tile_count);
+	for (int i = 0; i < count; i++) {
+		// Spread the seeds out so neighbouring games don't start with related sequences
+		Simulation* sim = (Simulation*)((uint8*)sims + (int64)i * stride);
+		init_data(&batch[i], sim, tile_count, grid_size, seed + (uint32)i * 0x9E3779B9u);
+		sim->state = PLAYING;
+	}
+	return batch;
+}
+
+void Game::free_batch(Data* batch) {
+	free_simulations(batch[0].sim);
+	delete[] batch;
+}
+
+/**
+ * Write the observation for one game of a batch (see batch_observation_size())
+ * @param FixedTileCount Number of tiles if it's known at compile time, 0 to read it from the simulation
+ */
+template<int32 FixedTileCount>
+void write_batch_observation(const Simulation* sim, float32* observation) {
+	observation[0] = sim->paddle_pos_x;
+	observation[1] = sim->ball_pos.x;
+	observation[2] = sim->ball_pos.y;
+	observation[3] = sim->ball_vel.x;
+	observation[4] = sim->ball_vel.y;
+
+	const int32 tile_count = FixedTileCount > 0 ? FixedTileCount : sim->tile_count;
+	const Tile* tiles = simulation_tiles(sim);
+	float32 health_scale = 1.0f / (float32)sim->level;
+	for (int i = 0; i < tile_count; i++) {
+		observation[5 + i] = (float32)tiles[i].health * health_scale;
+	}
+}
+
+typedef void (*BatchObservationWriter)(const Simulation* sim, float32* observation);
+
+/**
+ * Pick the observation writer for a batch, the default grid gets a loop bound known at compile time
+ */
+BatchObservationWriter batch_observation_writer(const Data* batch) {
+	if (batch[0].sim->tile_count == default_tile_count) {
+		return write_batch_observation<default_tile_count>;
+	}
+	return write_batch_observation<0>;
+}
+
+void Game::reset_batch(Data* batch, int32 count, float32* observations) {
+	const int32 observation_size = batch_observation_size(batch[0].sim->grid_size);
+	BatchObservationWriter write_observation = batch_observation_writer(batch);
+	for (int i = 0; i < count; i++) {
+		Simulation* sim = batch[i].sim;
+		reset_game(sim);
+		sim->state = PLAYING;
+		write_observation(sim, observations + i * observation_size);
+	}
+}
+
+void Game::step_batch(Data* batch, int32 count, float64 delta_time, const uint8* actions, 
+		float32* observations, float32* rewards, uint8* dones)
+{
+	const int32 observation_size = batch_observation_size(batch[0].sim->grid_size);
+	BatchObservationWriter write_observation = batch_observation_writer(batch);
+	for (int i = 0; i < count; i++) {
+		Simulation* sim = batch[i].sim;
+		int32 direction = actions[i] == 1 ? -1 : (actions[i] == 2 ? 1 : 0);
+
+		int32 score = sim->score;
+		batch[i].kernels->simulate(sim, delta_time, direction, NULL);
+		rewards[i] = (float32)(sim->score - score);
+
+		// Agents don't press start, so serve the ball again straight away
+		if (sim->state == GAME_OVER) {
+			reset_game(sim);
+			dones[i] = 1;
+		} else {
+			dones[i] = 0;
+		}
+		sim->state = PLAYING;
+
+		write_observation(sim, observations + i * observation_size);
+	}
+}
+
+/**
+ * Take the assets the loader finished since the last frame and build the shader
+ * programs once all of them arrived, without waiting on the driver if it
+ * compiles in parallel. Sets the load state to ready or failed when done.
+ */
+void advance_asset_loading(const Input* input, Data* data) {
+	AssetLoading* loading = data->loading;
+
+	if (loading->loader != NULL) {
+		AssetCompletion completion;
+		while (asset_loader_poll(loading->loader, &completion)) {
+			if (!completion.ok) {
+				data->load_state = ASSETS_FAILED;
+			}
+			loading->shader_sources[completion.request] = completion.view;
+		}
+
+		if (data->load_state == ASSETS_FAILED || asset_loader_done(loading->loader)) {
+			free_asset_loader(loading->loader);
+			loading->loader = NULL;
+		}
+		if (loading->loader != NULL || data->load_state == ASSETS_FAILED) {
+			return;
+		}
+		mark_startup_phase(input, "Shader sources");
+	}
+
+	const AssetView* sources = loading->shader_sources;
+	if (!loading->shader_builds_started) {
+		begin_cached_shader_program(&loading->shader_cache, &loading->rectangle_program, 
+				sources[RECTANGLE_VERT_SHADER].data, (int32)sources[RECTANGLE_VERT_SHADER].size, 
+				sources[RECTANGLE_FRAG_SHADER].data, (int32)sources[RECTANGLE_FRAG_SHADER].size);
+		begin_cached_shader_program(&loading->shader_cache, &loading->circle_program, 
+				sources[CIRCLE_VERT_SHADER].data, (int32)sources[CIRCLE_VERT_SHADER].size, 
+				sources[CIRCLE_FRAG_SHADER].data, (int32)sources[CIRCLE_FRAG_SHADER].size);
+		loading->shader_builds_started = true;
+		mark_startup_phase(input, "Start shader builds");
+	}
+
+	// Keep showing the loading screen while the driver works, without parallel compiling finishing just waits
+	if (loading->parallel_shader_compile && !(cached_shader_program_ready(&loading->rectangle_program) 
+			&& cached_shader_program_ready(&loading->circle_program))) {
+		return;
+	}
+
+	data->rectangle_shader = finish_cached_shader_program(&loading->shader_cache, &loading->rectangle_program);
+	if (data->rectangle_shader == 0) {
+		std::cout << "Failed to create rect shader program." << std::endl;
+		data->load_state = ASSETS_FAILED;
+		return;
+	}
+	mark_startup_phase(input, "Rectangle shader");
+
+	data->circle_shader = finish_cached_shader_program(&loading->shader_cache, &loading->circle_program);
+	if (data->circle_shader == 0) {
+		std::cout << "Failed to create circle shader program." << std::endl;
+		data->load_state = ASSETS_FAILED;
+		return;
+	}
+	mark_startup_phase(input, "Circle shader");
+
+	if (loading->shader_cache.enabled) {
+		std::cout << "Shader programs: " << loading->shader_cache.loaded_count << " loaded from cache, " 
+				<< loading->shader_cache.compiled_count << " compiled" << std::endl;
+	}
+	data->load_state = ASSETS_READY;
+}
+
+void Game::render(const Input* input, Data* data) {
+	PROFILE_SCOPE("Render");
+
+	//
+	// Loading screen until the shaders are ready (joining the loader and building programs can allocate)
+	//
+	if (data->load_state != ASSETS_READY) {
+		if (data->load_state == ASSETS_LOADING) {
+			advance_asset_loading(input, data);
+		}
+		if (data->load_state != ASSETS_READY) {
+			input->update_ui(data->sim->score, data->sim->lives, "Loading...");
+
+			float32 pulse = 0.5f + 0.5f * (float32)sin(input->frame_time * 4.0);
+			glViewport(0, 0, input->frame_buffer_size.x, input->frame_buffer_size.y);
+			glClearColor(0.0f, 0.2f + 0.1f * pulse, 0.2f + 0.1f * pulse, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			return;
+		}
+	}
+
+	ASSERT_NO_ALLOCATIONS("Game::render");
+
+	const Simulation* sim = data->sim;
+
+	//
+	// Update window title
+	//
+	switch (sim->state) {
+		case PAUSED:
+			input->update_ui(sim->score, sim->lives, "Press Spacebar to Play");
+			break;
+		case PLAYING:
+			input->update_ui(sim->score, sim->lives, NULL);
+			break;
+		case GAME_OVER:
+			input->update_ui(sim->score, sim->lives, "Press Spacebar to Play Again");
+			break;
+	}
+
+	const float world_to_clip[9] = { 
+		2.0f / world_size.x, 0.0f,                0.0f,
+		0.0f,                2.0f / world_size.y, 0.0f,
+		0.0f,                0.0f,                1.0f
+	};
+
+	glViewport(0, 0, input->frame_buffer_size.x, input->frame_buffer_size.y);
 
 	glClearColor(0.0f, 0.5f, 0.5f, 7.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
@@ -463,10 +1746,35 @@ void Game::render(const Input* input, Data* data) {
 		glUniformMatrix3fv(world_to_clip_location, 1, GL_FALSE, world_to_clip);
 
 		// Render ball
-		glUniform2f(center_pos_location, data->ball_pos.x, data->ball_pos.y);
+		glUniform2f(center_pos_location, sim->ball_pos.x, sim->ball_pos.y);
 		glUniform1f(radius_location, ball_radius);
 		glUniformMatrix3fv(world_to_clip_location, 1, GL_FALSE, world_to_clip);
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+		// Render predicted ball path as a line of dots
+		if (input->show_trajectory && sim->state != GAME_OVER) {
+			PROFILE_SCOPE("Trajectory");
+
+			Trajectory trajectory;
+			predict_trajectory(data, trajectory_preview_bounces, &trajectory);
+
+			glUniform1f(radius_location, trajectory_dot_radius);
+			float32 offset = 0.0f; // Keeps the dot spacing even across bounces
+			for (int i = 1; i < trajectory.point_count; i++) {
+				Vec2 start = trajectory.points[i - 1];
+				Vec2 delta = trajectory.points[i] - start;
+				float32 length = magnitude(delta);
+				Vec2 direction = normalize(delta);
+
+				float32 distance = offset;
+				for (; distance < length; distance += trajectory_dot_spacing) {
+					Vec2 dot_pos = start + direction * distance;
+					glUniform2f(center_pos_location, dot_pos.x, dot_pos.y);
+					glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+				}
+				offset = distance - length;
+			}
+		}
 	}
 
 	// Rectangles
@@ -483,25 +1791,18 @@ void Game::render(const Input* input, Data* data) {
 		// Render paddle
 		{
 			glUniform2f(scale_location, paddle_size.x, paddle_size.y);
-			glUniform2f(center_pos_location, data->paddle_pos_x, paddle_pos_y);
+			glUniform2f(center_pos_location, sim->paddle_pos_x, paddle_pos_y);
 			glUniform1f(alpha_location, 1.0f);
 			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		}
 
 		// Render tiles
 		{
-			// @optimize: These could be batched together
-			glUniform2f(scale_location, tile_size.x - 0.05f, tile_size.y - 0.05f);
-			for (int i = 0; i < tile_count; i++) {
-				Tile tile = data->tiles[i];
-				if (tile.health < 1) {
-					continue;
-				}
+			PROFILE_SCOPE("Tiles");
 
-				glUniform2f(center_pos_location, tile.pos.x, tile.pos.y);
-				glUniform1f(alpha_location, (float32)tile.health / (float32)data->level);
-				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-			}
+			// @optimize: These could be batched together
+			glUniform2f(scale_location, sim->tile_size.x - 0.05f, sim->tile_size.y - 0.05f);
+			data->kernels->render_tiles(sim, center_pos_location, alpha_location);
 		}
 	}
 
@@ -3,6 +3,15 @@
 #include "types.hpp"
 #include "vector.hpp"
 
+// Linear allocator (see arena.hpp)
+struct Arena;
+
+// Packed asset files (see assetpack.hpp)
+struct AssetPack;
+
+// Level file contents (see level.hpp)
+struct Level;
+
 /**
  * This file defines the interface between 
  * the platform layer and the game logic
@@ -12,6 +21,17 @@ namespace Game {
 	// Forward declaration of Game::Data (Platform layer shouldn't care about contents)
 	struct Data;
 
+	// Ring buffer of previous frames (see create_rewind_buffer())
+	struct RewindBuffer;
+
+	// Computer player (see create_autopilot())
+	struct Autopilot;
+
+	// Tile grid of the built-in level, other grid sizes can be picked at runtime
+	const int32 default_grid_size_x = 12;
+	const int32 default_grid_size_y = 3;
+	const int32 max_grid_tile_count = 1 << 24; // Keeps the size of a simulation in an int32
+
 	// Filled out by platform layer every frame
 	struct Input {
 		Vec2Int frame_buffer_size;
@@ -23,16 +43,184 @@ namespace Game {
 		bool right_key_pressed;
 		bool start_key_pressed;
 		bool start_key_pressed_prev;
+		bool rewind_key_pressed;
+		bool show_trajectory; // Draw the predicted path of the ball
+
+		Arena* permanent_arena; // Memory that lives as long as the game, init() allocates the game data from it
+		Arena* frame_arena;     // Scratch memory for the current frame, reset by the platform layer at the start of every frame
+
+		const AssetPack* assets; // Mapped by the platform layer, the shaders are loaded from it in the background
+		Vec2Int grid_size;       // Tile grid of the built-in level, (0, 0) for the default grid
+		int32 tile_capacity;     // Most tiles a loaded level can have, init() makes room for at least the built-in level
+
+		void* (*get_gl_proc_address)(const char* name); // Loads OpenGL functions that glad doesn't (ex. program binaries)
+		const char* shader_cache_directory;             // Where init() caches linked shader programs, NULL to always compile them
 
 		void (*update_ui)(int32 score, int32 lives, const char* info);
+		void (*trace_startup)(const char* phase); // Called by init() as each of its phases finishes, can be NULL
+	};
+
+	// Max number of tiles reported in an observation
+	const int32 observation_tile_capacity = 64;
+
+	// Snapshot of the game state for agents that play the game without a window
+	struct Observation {
+		int32 state; // 0 = Paused, 1 = Playing, 2 = Game Over
+		int32 score;
+		int32 level;
+		int32 lives;
+
+		float32 paddle_pos_x;
+		Vec2 ball_pos;
+		Vec2 ball_vel;
+
+		int32 tile_count;
+		int32 tile_health[observation_tile_capacity];
 	};
 
-	// Initialize the game
+	// Max number of bounces predict_trajectory() can follow
+	const int32 trajectory_max_bounces = 32;
+
+	// Predicted path of the ball center
+	struct Trajectory {
+		int32 point_count; // Start position, one point per bounce and the point the ball leaves the world if lost
+		Vec2  points[trajectory_max_bounces + 2];
+		bool  ball_lost;   // True if the path ends with the ball getting past the paddle
+	};
+
+	// Progress of the assets init() loads in the background
+	enum LoadState {
+		ASSETS_LOADING, // render() shows a loading screen and update() does nothing
+		ASSETS_READY,
+		ASSETS_FAILED   // An asset is missing or a shader didn't build, the game can't be shown
+	};
+
+	// Bytes init() allocates from the permanent arena for the given Input::grid_size and Input::tile_capacity
+	uint64 init_memory_size(Vec2Int grid_size, int32 tile_capacity);
+
+	// Initialize the game, the assets keep loading after it returns (see load_state())
 	Data* init(const Input* input);
 
+	// Initialize the game on a full grid of tiles without any rendering resources, render() must not be called
+	// (remember to call free_headless() after)
+	Data* init_headless(Vec2Int grid_size);
+
+	void free_headless(Data* state);
+
+	// Where loading the assets is at, render() moves it along every frame
+	LoadState load_state(const Data* state);
+
+	// Fill out an observation of the current game state
+	void observe(const Data* state, Observation* observation);
+
+	// Replace the tiles with the ones of a level file and restart the game on it, nothing is allocated
+	// so the level must fit the tile capacity the game was initialized with (false if it doesn't)
+	bool load_level(Data* state, const Level* level);
+
+	// Jump to the start of a level with full tiles, the game is paused until start is pressed
+	void start_level(Data* state, int32 level);
+
+	// True if the last update hit the max collision iterations (the ball stopped short of where it should be)
+	bool collision_limit_hit(const Data* state);
+
+	// Predict where the ball goes for the next bounce_count bounces, assuming the paddle stays where it is
+	void predict_trajectory(const Data* state, int32 bounce_count, Trajectory* trajectory);
+
+	//
+	// Snapshots of the simulation state (everything except rendering resources)
+	//
+
+	// Size in bytes of a snapshot, depends on the number of tiles of the current level
+	int32 snapshot_size(const Data* state);
+
+	// Copy the simulation state into a snapshot of snapshot_size() bytes
+	void save_snapshot(const Data* state, void* snapshot);
+
+	// Restore the simulation state from a snapshot (of a level that fits the tile capacity)
+	void load_snapshot(Data* state, const void* snapshot);
+
+	// Allocate a ring buffer for the last frame_count frames of levels with up to tile_capacity tiles
+	// (remember to call free_rewind_buffer() after)
+	RewindBuffer* create_rewind_buffer(int32 frame_count, int32 tile_capacity);
+
+	void free_rewind_buffer(RewindBuffer* buffer);
+
+	// Record the current simulation state, replacing the oldest frame once the buffer is full
+	void record_frame(RewindBuffer* buffer, const Data* state);
+
+	// Number of frames currently in the buffer
+	int32 recorded_frame_count(const RewindBuffer* buffer);
+
+	// Restore the frame recorded frames_back frames before the latest one and drop the frames after it
+	// @returns False if there aren't enough frames recorded (nothing is restored)
+	bool rewind(RewindBuffer* buffer, Data* state, int32 frames_back);
+
+	// Record every update into buffer so the rewind key steps back through it, NULL to stop recording
+	// (init() does this with a buffer of its own, the game doesn't free a buffer set here)
+	void set_rewind_buffer(Data* state, RewindBuffer* buffer);
+
+	//
+	// Autopilot that moves the paddle by simulating many possible futures in parallel
+	//
+
+	// Create an autopilot (remember to call free_autopilot() after)
+	// thread_count: Threads used for simulating, 0 to use every hardware thread
+	Autopilot* create_autopilot(int32 thread_count);
+
+	void free_autopilot(Autopilot* autopilot);
+
+	// Pick the paddle movement for the next update and set the left/right keys in input
+	void autopilot_decide(Autopilot* autopilot, const Data* state, Input* input);
+
+	// Average number of decisions made per second of time spent deciding
+	float64 autopilot_decisions_per_second(const Autopilot* autopilot);
+
 	// Update the game logic for a frame
 	void update(const Input* input, Data* state);
 
 	// Render a frame
 	void render(const Input* input, Data* state);
+
+	//
+	// Batch simulation for training agents, the games in a batch are stored contiguously
+	// and are always playing (paused games are resumed and finished games are reset).
+	// Every game in a batch plays a full grid of tiles of the same size.
+	//
+
+	// Number of floats written per game to the observations of a batch
+	// (paddle x, ball position, ball velocity, health of each tile relative to the level)
+	int32 batch_observation_size(Vec2Int grid_size);
+
+	// Initialize count games without rendering resources (remember to call free_batch() after)
+	Data* init_batch(int32 count, uint32 seed, Vec2Int grid_size);
+
+	// Free games created with init_batch()
+	void free_batch(Data* batch);
+
+	// Start new games for the whole batch
+	void reset_batch(Data* batch, int32 count, float32* observations);
+
+	// Step every game in the batch by one frame
+	// actions: 0 to stay still, 1 to move left, 2 to move right
+	// rewards: Score gained during the step
+	// dones: 1 if the game ended during the step (the observation is of the new game)
+	void step_batch(Data* batch, int32 count, float64 delta_time, const uint8* actions, 
+			float32* observations, float32* rewards, uint8* dones);
+
+	//
+	// SIMD batch simulation where each vector lane is a different game (see lanes.cpp).
+	// Takes the same arguments and gives the same results as the batch functions above.
+	//
+
+	struct LaneBatch;
+
+	// Initialize count games (remember to call free_lanes() after)
+	LaneBatch* init_lanes(int32 count, uint32 seed, Vec2Int grid_size);
+
+	void free_lanes(LaneBatch* batch);
+
+	void reset_lanes(LaneBatch* batch, float32* observations);
+
+	void step_lanes(LaneBatch* batch, float64 delta_time, const uint8* actions, 
+			float32* observations, float32* rewards, uint8* dones);
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "types.hpp"
+#include "vector.hpp"
+#include "game.hpp"
+
+/**
+ * Constants and helpers shared by the game simulation 
+ * and the SIMD lane simulation (see lanes.cpp)
+ */
+
+const float32 PI = 3.14159265;
+
+// Size of the window in world units (Origin is in the center of the window)
+const Vec2 world_size = Vec2(16, 9);
+
+const Vec2Int default_tile_grid_size = Vec2Int(Game::default_grid_size_x, Game::default_grid_size_y);
+const int32   default_tile_count     = Game::default_grid_size_x * Game::default_grid_size_y;
+
+const float32 tile_grid_width      = 12.0f;             // Grids of any size are stretched to this width in world units
+const float32 tile_grid_max_height = 3.0f;              // Rows shrink once a grid would be taller than this
+const float32 tile_max_height      = 0.5f;
+const Vec2    tile_grid_offset     = Vec2(0.0f, -1.0f); // Grid offset from the top of the window
+
+const float32 paddle_start_pos_x = 0.0f;              // Start x position of the paddle
+const float32 paddle_pos_y       = -4.0f;             // Constant y position of the paddle
+const Vec2    paddle_size        = Vec2(2.0f, 0.25f); // Size of the paddle in world units
+const float32 paddle_speed       = 6.0f;              // Horizontal speed of the paddle in units per second
+
+const Vec2    ball_start_pos     = Vec2(0.0f, 0.0f);  // World start position of the ball
+const float32 ball_radius        = 0.2f;              // Radius of the ball in world units
+const float32 ball_base_speed    = 4.5f;              // Ball speed on level 1
+const float32 ball_level_speed   = 0.5f;              // Speed the ball increases by every level
+
+// When the ball hits near the edges of the paddle the ball bounces off 
+// with extra rotation, this gives the player a bit of control over where
+// the ball goes. This is the max addition rotation that can be applied to 
+// the ball during the paddle bounce in radians.
+const float32 ball_paddle_max_rotation = 15.0f * (3.14159f / 180.0f);
+
+/**
+ * Get the upper left corner of a grid of tiles, grids are centered horizontally
+ */
+inline Vec2 grid_top_left(Vec2Int grid_size, Vec2 grid_tile_size) {
+	return Vec2(-(grid_tile_size.x * grid_size.x * 0.5f) + tile_grid_offset.x, (world_size.y * 0.5f) + tile_grid_offset.y);
+}
+
+/**
+ * Get the center of a tile in a grid, tiles are laid out in rows starting at the upper left
+ */
+inline Vec2 grid_tile_position(Vec2Int grid_size, Vec2 grid_tile_size, int32 index) {
+	int32 x = index % grid_size.x;
+	int32 y = index / grid_size.x;
+
+	Vec2 pos;
+	pos.x = -(grid_tile_size.x * grid_size.x * 0.5f) + (grid_tile_size.x * 0.5f) + tile_grid_offset.x + grid_tile_size.x * x;
+	pos.y = (world_size.y * 0.5f) - (grid_tile_size.y * 0.5f) + tile_grid_offset.y - grid_tile_size.y * y;
+	return pos;
+}
+
+/**
+ * Get the size of the tiles of a grid fitted to the grid area, the default grid gets 1 by 0.5 tiles
+ */
+inline Vec2 grid_fit_tile_size(Vec2Int grid_size) {
+	float32 height = tile_grid_max_height / (float32)grid_size.y;
+	return Vec2(tile_grid_width / (float32)grid_size.x, height < tile_max_height ? height : tile_max_height);
+}
+
+/**
+ * Get a random number from 0 to 1 (xorshift32, state must not be 0)
+ */
+inline float32 random_float(uint32* state) {
+	uint32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return (x >> 8) / (float32)(1 << 24);
+}
@@ -0,0 +1,810 @@
+#include <math.h>
+#include <new>
+#include <string.h>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "game.hpp"
+#include "gamecommon.hpp"
+
+using namespace Game;
+
+/**
+ * SIMD simulation where every lane is a different game.
+ *
+ * All games share the world size, tile size and tile layout, so the wall, paddle
+ * and tile tests are the same instructions for every lane and only the ball, paddle
+ * and tile health differ. The grid size is picked at runtime, the default grid
+ * gets its own instantiation of the tile loops with the tile count known at
+ * compile time. This mirrors simulate() in game.cpp, so a lane behaves
+ * like a game in a batch from init_batch().
+ *
+ * The lane types use the GCC/Clang vector extensions and are sized to the widest
+ * vector registers the build targets: 16 lanes with -mavx512f, 8 lanes with -mavx2
+ * and 4 lanes for the SSE/NEON baseline.
+ */
+
+#if defined(__AVX512F__)
+const int32 lane_count = 16;
+#elif defined(__AVX__)
+const int32 lane_count = 8;
+#else
+const int32 lane_count = 4;
+#endif
+
+typedef float32 LaneFloat __attribute__((vector_size(lane_count * sizeof(float32))));
+typedef int32   LaneInt   __attribute__((vector_size(lane_count * sizeof(int32))));
+
+// Lane tile bitsets need a bit per lane
+static_assert(lane_count <= 32, "Lane count must fit in a uint32 bitset");
+
+//
+// Lane Functions
+//
+
+inline LaneFloat lane_float(float32 value) {
+	LaneFloat result;
+	for (int i = 0; i < lane_count; i++) {
+		result[i] = value;
+	}
+	return result;
+}
+
+inline LaneInt lane_int(int32 value) {
+	LaneInt result;
+	for (int i = 0; i < lane_count; i++) {
+		result[i] = value;
+	}
+	return result;
+}
+
+/**
+ * Pick a where the mask is set and b everywhere else
+ */
+inline LaneFloat lane_select(LaneInt mask, LaneFloat a, LaneFloat b) {
+	return (LaneFloat)(((LaneInt)a & mask) | ((LaneInt)b & ~mask));
+}
+
+inline LaneInt lane_select(LaneInt mask, LaneInt a, LaneInt b) {
+	return (a & mask) | (b & ~mask);
+}
+
+inline LaneFloat lane_sqrt(LaneFloat v) {
+	LaneFloat result;
+	const float32* in = (const float32*)&v;
+	float32* out = (float32*)&result;
+
+	#if defined(__AVX512F__)
+	_mm512_storeu_ps(out, _mm512_maskz_sqrt_ps(0xFFFF, _mm512_loadu_ps(in)));
+	#elif defined(__AVX__)
+	_mm256_storeu_ps(out, _mm256_sqrt_ps(_mm256_loadu_ps(in)));
+	#elif defined(__SSE__)
+	_mm_storeu_ps(out, _mm_sqrt_ps(_mm_loadu_ps(in)));
+	#elif defined(__ARM_NEON) && defined(__aarch64__)
+	vst1q_f32(out, vsqrtq_f32(vld1q_f32(in)));
+	#else
+	for (int i = 0; i < lane_count; i++) {
+		out[i] = sqrt(in[i]);
+	}
+	#endif
+
+	return result;
+}
+
+/**
+ * Get a bit per lane that is set when the mask is set
+ */
+inline uint32 lane_bits(LaneInt mask) {
+	#if defined(__AVX512F__)
+	return _mm512_cmplt_epi32_mask((__m512i)mask, _mm512_setzero_si512());
+	#elif defined(__AVX__)
+	return _mm256_movemask_ps((__m256)mask);
+	#elif defined(__SSE__)
+	return _mm_movemask_ps((__m128)mask);
+	#else
+	uint32 bits = 0;
+	for (int i = 0; i < lane_count; i++) {
+		bits |= (uint32)(mask[i] & 1) << i;
+	}
+	return bits;
+	#endif
+}
+
+inline LaneInt lane_min(LaneInt a, LaneInt b) {
+	return lane_select(a < b, a, b);
+}
+
+inline LaneInt lane_max(LaneInt a, LaneInt b) {
+	return lane_select(a > b, a, b);
+}
+
+inline LaneFloat lane_min(LaneFloat a, LaneFloat b) {
+	return lane_select(a < b, a, b);
+}
+
+inline LaneFloat lane_max(LaneFloat a, LaneFloat b) {
+	return lane_select(a > b, a, b);
+}
+
+/**
+ * Round down lanes between -1 and 2^23, cheaper than floor() on each lane
+ */
+inline LaneInt lane_floor(LaneFloat v) {
+	// Converting truncates, which rounds down once the value is positive
+	return __builtin_convertvector(v + 2.0f, LaneInt) - 2;
+}
+
+/**
+ * Get a mask that is set for lanes with their bit set
+ */
+inline LaneInt lane_mask(uint32 bits) {
+	LaneInt result;
+	for (int i = 0; i < lane_count; i++) {
+		result[i] = (bits >> i) & 1 ? -1 : 0;
+	}
+	return result;
+}
+
+//
+// Lane Collision
+//
+// Each function matches the scalar version in raycast.hpp / collision.hpp,
+// but reports the lanes that hit through a mask instead of a return value.
+//
+
+struct LaneVec2 {
+	LaneFloat x, y;
+};
+
+struct LaneHit {
+	LaneInt   mask;
+	LaneFloat distance;
+	LaneVec2  point;
+	LaneVec2  normal;
+};
+
+inline LaneHit lane_no_hit() {
+	LaneHit hit;
+	hit.mask = lane_int(0);
+	hit.distance = lane_float(INFINITY);
+	hit.point.x = hit.point.y = lane_float(0.0f);
+	hit.normal.x = hit.normal.y = lane_float(0.0f);
+	return hit;
+}
+
+inline LaneFloat lane_magnitude(LaneFloat x, LaneFloat y) {
+	return lane_sqrt(x * x + y * y);
+}
+
+/**
+ * Take the hits from b for lanes in mask
+ */
+inline void lane_take_hit(LaneHit* a, const LaneHit* b, LaneInt mask) {
+	a->mask      |= mask;
+	a->distance  = lane_select(mask, b->distance, a->distance);
+	a->point.x   = lane_select(mask, b->point.x, a->point.x);
+	a->point.y   = lane_select(mask, b->point.y, a->point.y);
+	a->normal.x  = lane_select(mask, b->normal.x, a->normal.x);
+	a->normal.y  = lane_select(mask, b->normal.y, a->normal.y);
+}
+
+void lane_raycast_vertical_line(LaneVec2 ray_pos, LaneVec2 ray_dir, LaneFloat x, LaneHit* hit) {
+	LaneFloat delta_x = x - ray_pos.x;
+	LaneFloat delta_y = delta_x * (ray_dir.y / ray_dir.x);
+
+	hit->mask = delta_x * ray_dir.x > 0.0f;
+	hit->point.x = x;
+	hit->point.y = ray_pos.y + delta_y;
+	hit->distance = lane_magnitude(delta_x, delta_y);
+	hit->normal.x = lane_select(delta_x > 0.0f, lane_float(-1.0f), lane_float(1.0f));
+	hit->normal.y = lane_float(0.0f);
+}
+
+void lane_raycast_horizontal_line(LaneVec2 ray_pos, LaneVec2 ray_dir, LaneFloat y, LaneHit* hit) {
+	LaneFloat delta_y = y - ray_pos.y;
+	LaneFloat delta_x = delta_y * (ray_dir.x / ray_dir.y);
+
+	hit->mask = delta_y * ray_dir.y > 0.0f;
+	hit->distance = lane_magnitude(delta_x, delta_y);
+	hit->point.x = ray_pos.x + delta_x;
+	hit->point.y = y;
+	hit->normal.x = lane_float(0.0f);
+	hit->normal.y = lane_select(delta_y > 0.0f, lane_float(-1.0f), lane_float(1.0f));
+}
+
+void lane_raycast_circle(LaneVec2 ray_pos, LaneVec2 ray_dir, LaneVec2 circle_pos, float32 circle_radius, LaneHit* hit) {
+	LaneFloat ab_x = circle_pos.x - ray_pos.x;
+	LaneFloat ab_y = circle_pos.y - ray_pos.y;
+	LaneFloat ab_dot_dir = ab_x * ray_dir.x + ab_y * ray_dir.y;
+	LaneFloat c_x = ray_pos.x + ab_dot_dir * ray_dir.x;
+	LaneFloat c_y = ray_pos.y + ab_dot_dir * ray_dir.y;
+
+	LaneFloat mag_bc = lane_magnitude(c_x - circle_pos.x, c_y - circle_pos.y);
+	LaneInt mask = mag_bc <= circle_radius;
+
+	// Clamp so lanes that missed don't take the root of a negative
+	LaneFloat cd_squared = circle_radius * circle_radius - mag_bc * mag_bc;
+	LaneFloat mag_cd = lane_sqrt(lane_select(mask, cd_squared, lane_float(0.0f)));
+	LaneFloat d_x = c_x - ray_dir.x * mag_cd;
+	LaneFloat d_y = c_y - ray_dir.y * mag_cd;
+
+	LaneFloat mag_ad = ray_dir.x * (d_x - ray_pos.x) + ray_dir.y * (d_y - ray_pos.y);
+	mask &= mag_ad >= 0.0f;
+
+	LaneFloat normal_x = d_x - circle_pos.x;
+	LaneFloat normal_y = d_y - circle_pos.y;
+	LaneFloat normal_mag = lane_magnitude(normal_x, normal_y);
+
+	hit->mask = mask;
+	hit->distance = mag_ad;
+	hit->point.x = d_x;
+	hit->point.y = d_y;
+	hit->normal.x = normal_x / normal_mag;
+	hit->normal.y = normal_y / normal_mag;
+}
+
+void lane_moving_circle_to_vertical_line_check(LaneVec2 p1, LaneVec2 p2, float32 radius, float32 line_x_pos, LaneHit* hit) {
+	LaneInt left = p1.x < line_x_pos - radius;
+	LaneInt right = p1.x > line_x_pos + radius;
+	LaneInt crossing = (left & (p2.x >= line_x_pos - radius)) | (right & (p2.x <= line_x_pos + radius));
+
+	LaneVec2 delta = { p2.x - p1.x, p2.y - p1.y };
+	LaneFloat x = lane_select(left, lane_float(line_x_pos - radius), lane_float(line_x_pos + radius));
+	lane_raycast_vertical_line(p1, delta, x, hit);
+	hit->mask &= crossing;
+}
+
+void lane_moving_circle_to_horizontal_line_check(LaneVec2 p1, LaneVec2 p2, float32 radius, float32 line_y_pos, LaneHit* hit) {
+	LaneInt below = p1.y < line_y_pos - radius;
+	LaneInt above = p1.y > line_y_pos + radius;
+	LaneInt crossing = (below & (p2.y >= line_y_pos - radius)) | (above & (p2.y <= line_y_pos + radius));
+
+	LaneVec2 delta = { p2.x - p1.x, p2.y - p1.y };
+	LaneFloat y = lane_select(below, lane_float(line_y_pos - radius), lane_float(line_y_pos + radius));
+	lane_raycast_horizontal_line(p1, delta, y, hit);
+	hit->mask &= crossing;
+}
+
+/**
+ * Matches moving_circle_to_retangle_collision_check(), only lanes in the active mask are tested.
+ */
+void lane_moving_circle_to_rectangle_check(LaneVec2 p1, LaneVec2 p2, float32 radius, LaneVec2 center, Vec2 size,
+		LaneInt active, LaneHit* hit)
+{
+	// Quick check
+	LaneFloat max_x = center.x + size.x * 0.5f + radius;
+	LaneFloat max_y = center.y + size.y * 0.5f + radius;
+	LaneFloat min_x = center.x - size.x * 0.5f - radius;
+	LaneFloat min_y = center.y - size.y * 0.5f - radius;
+	LaneInt outside = ((p1.x > max_x) & (p2.x > max_x)) | ((p1.y > max_y) & (p2.y > max_y))
+			| ((p1.x < min_x) & (p2.x < min_x)) | ((p1.y < min_y) & (p2.y < min_y));
+
+	LaneInt possible = active & ~outside;
+	hit->mask = lane_int(0);
+	if (lane_bits(possible) == 0) {
+		return;
+	}
+
+	LaneFloat delta_x = p2.x - p1.x;
+	LaneFloat delta_y = p2.y - p1.y;
+	LaneFloat delta_mag = lane_magnitude(delta_x, delta_y);
+	LaneVec2 direction = { delta_x / delta_mag, delta_y / delta_mag };
+
+	// Left and right sides, only one can apply depending on the direction
+	LaneHit side_x;
+	{
+		LaneFloat x = lane_select(direction.x > 0.0f, center.x - size.x * 0.5f - radius, center.x + size.x * 0.5f + radius);
+		lane_raycast_vertical_line(p1, direction, x, &side_x);
+		side_x.mask &= (direction.x != 0.0f) & (side_x.point.y >= center.y - size.y * 0.5f)
+				& (side_x.point.y <= center.y + size.y * 0.5f);
+	}
+
+	// Bottom and top sides
+	LaneHit side_y;
+	{
+		LaneFloat y = lane_select(direction.y > 0.0f, center.y - size.y * 0.5f - radius, center.y + size.y * 0.5f + radius);
+		lane_raycast_horizontal_line(p1, direction, y, &side_y);
+		side_y.mask &= (direction.y != 0.0f) & (side_y.point.x >= center.x - size.x * 0.5f)
+				& (side_y.point.x <= center.x + size.x * 0.5f);
+	}
+
+	// A side hit is always the closest, left/right are checked first like the scalar version
+	LaneHit result = lane_no_hit();
+	lane_take_hit(&result, &side_x, side_x.mask);
+	lane_take_hit(&result, &side_y, side_y.mask & ~side_x.mask);
+	LaneInt side_hit = result.mask;
+
+	// Corners for lanes that didn't hit a side
+	LaneInt need_corners = possible & ~side_hit;
+	if (lane_bits(need_corners) != 0) {
+		LaneInt right = direction.x > 0.0f;
+		LaneInt left  = direction.x < 0.0f;
+		LaneInt up    = direction.y > 0.0f;
+		LaneInt down  = direction.y < 0.0f;
+
+		LaneFloat x_min = center.x - size.x * 0.5f;
+		LaneFloat x_max = center.x + size.x * 0.5f;
+		LaneFloat y_min = center.y - size.y * 0.5f;
+		LaneFloat y_max = center.y + size.y * 0.5f;
+
+		const LaneVec2 corners[4] = {
+			{ x_min, y_min }, // Bottom-left
+			{ x_min, y_max }, // Top-left
+			{ x_max, y_min }, // Bottom-right
+			{ x_max, y_max }  // Top-right
+		};
+		const LaneInt corner_masks[4] = { right | up, right | down, left | up, left | down };
+
+		for (int i = 0; i < 4; i++) {
+			LaneHit corner;
+			lane_raycast_circle(p1, direction, corners[i], radius, &corner);
+			LaneInt closer = need_corners & corner_masks[i] & corner.mask & (corner.distance < result.distance);
+			lane_take_hit(&result, &corner, closer);
+		}
+	}
+
+	hit->mask = possible & (result.distance < delta_mag);
+	hit->distance = result.distance;
+	hit->point = result.point;
+	hit->normal = result.normal;
+}
+
+//
+// Lane Simulation
+//
+
+/**
+ * State for lane_count games, followed in memory by the tiles of the group:
+ * LaneInt tile_health[tile_count] then uint32 tile_alive[tile_count]
+ * (see lane_tile_health() and lane_tile_alive())
+ */
+struct LaneGroup {
+	LaneFloat paddle_pos_x;
+	LaneVec2  ball_pos;
+	LaneVec2  ball_vel;
+
+	LaneInt score;
+	LaneInt level;
+	LaneInt lives;
+
+	uint32 random_state[lane_count];
+};
+
+struct Game::LaneBatch {
+	uint8*  groups;       // group_count groups of group_stride bytes, each on its own cache lines
+	int32   group_stride;
+	int32   group_count;
+	int32   count;
+
+	Vec2Int grid_size;
+	int32   tile_count;
+	Vec2    tile_size;
+	Vec2*   tile_pos;
+	Vec2    tile_min;     // Bounds of all tiles, used to skip the tile tests when no ball is near them
+	Vec2    tile_max;
+};
+
+/**
+ * Bytes of a group and its tiles, rounded up to a cache line
+ */
+int32 lane_group_stride(int32 tile_count) {
+	int32 size = (int32)(sizeof(LaneGroup) + tile_count * (sizeof(LaneInt) + sizeof(uint32)));
+	return (size + 63) / 64 * 64;
+}
+
+inline LaneGroup* lane_group(const LaneBatch* batch, int32 index) {
+	return (LaneGroup*)(batch->groups + (int64)index * batch->group_stride);
+}
+
+// Health of every tile in every lane
+inline LaneInt* lane_tile_health(LaneGroup* group) {
+	return (LaneInt*)(group + 1);
+}
+
+inline const LaneInt* lane_tile_health(const LaneGroup* group) {
+	return (const LaneInt*)(group + 1);
+}
+
+// Bit per lane for every tile, set if the tile has health in that lane
+inline uint32* lane_tile_alive(LaneGroup* group, int32 tile_count) {
+	return (uint32*)(lane_tile_health(group) + tile_count);
+}
+
+/**
+ * Number of tiles for the tile loops, FixedTileCount is the tile count when it's known at compile time (0 if not)
+ */
+template<int32 FixedTileCount>
+inline int32 lane_tile_count(const LaneBatch* batch) {
+	return FixedTileCount > 0 ? FixedTileCount : batch->tile_count;
+}
+
+void lane_reset_ball_and_paddle(LaneGroup* group, int32 lane, float32 ball_speed) {
+	group->ball_pos.x[lane] = ball_start_pos.x;
+	group->ball_pos.y[lane] = ball_start_pos.y;
+	float32 angle = random_float(&group->random_state[lane]) * (PI * 0.5f) + (PI * 0.25f); // From 45 to 135 degrees
+	group->ball_vel.x[lane] = ball_speed * cos(angle);
+	group->ball_vel.y[lane] = ball_speed * sin(angle);
+
+	group->paddle_pos_x[lane] = paddle_start_pos_x;
+}
+
+template<int32 FixedTileCount>
+void lane_set_tile_health(const LaneBatch* batch, LaneGroup* group, int32 lane, int32 health) {
+	const int32 tile_count = lane_tile_count<FixedTileCount>(batch);
+	LaneInt* tile_health = lane_tile_health(group);
+	uint32* tile_alive = lane_tile_alive(group, tile_count);
+	for (int i = 0; i < tile_count; i++) {
+		tile_health[i][lane] = health;
+		if (health > 0) {
+			tile_alive[i] |= 1u << lane;
+		} else {
+			tile_alive[i] &= ~(1u << lane);
+		}
+	}
+}
+
+/**
+ * Range of grid cells a ball can touch in each lane, cell (x, y) is tile x + y * grid_size.x
+ */
+struct LaneCells {
+	LaneInt min_x, max_x;
+	LaneInt min_y, max_y;
+};
+
+/**
+ * Find the tiles the balls of the lanes in mask can touch moving from p1 to p2, matching tiles_in_reach() 
+ * in game.cpp in each lane. Also finds the range covering every lane in mask, which is empty (min > max) 
+ * if no ball can reach a tile.
+ */
+void lane_tiles_in_reach(const LaneBatch* batch, LaneVec2 p1, LaneVec2 p2, LaneInt mask, 
+		LaneCells* cells, Vec2Int* min_cell, Vec2Int* max_cell)
+{
+	// Columns count right from the left edge of the grid and rows count down from the top,
+	// grown by a cell so rounding never leaves out a tile a ball touches. Clamped to just 
+	// outside the grid before rounding, far away paths would overflow the conversion
+	Vec2 top_left = grid_top_left(batch->grid_size, batch->tile_size);
+	LaneFloat columns = lane_float((float32)batch->grid_size.x);
+	LaneFloat rows = lane_float((float32)batch->grid_size.y);
+	LaneFloat column_min = (lane_min(p1.x, p2.x) - ball_radius - top_left.x) / batch->tile_size.x;
+	LaneFloat column_max = (lane_max(p1.x, p2.x) + ball_radius - top_left.x) / batch->tile_size.x;
+	LaneFloat row_min = (top_left.y - lane_max(p1.y, p2.y) - ball_radius) / batch->tile_size.y;
+	LaneFloat row_max = (top_left.y - lane_min(p1.y, p2.y) + ball_radius) / batch->tile_size.y;
+	column_min = lane_min(lane_max(column_min, lane_float(-1.0f)), columns + 1.0f);
+	column_max = lane_min(lane_max(column_max, lane_float(-1.0f)), columns + 1.0f);
+	row_min = lane_min(lane_max(row_min, lane_float(-1.0f)), rows + 1.0f);
+	row_max = lane_min(lane_max(row_max, lane_float(-1.0f)), rows + 1.0f);
+
+	// Lanes outside the mask get an empty range
+	cells->min_x = lane_select(mask, lane_max(lane_floor(column_min) - 1, lane_int(0)), lane_int(batch->grid_size.x));
+	cells->max_x = lane_select(mask, lane_min(lane_floor(column_max) + 1, lane_int(batch->grid_size.x - 1)), lane_int(-1));
+	cells->min_y = lane_select(mask, lane_max(lane_floor(row_min) - 1, lane_int(0)), lane_int(batch->grid_size.y));
+	cells->max_y = lane_select(mask, lane_min(lane_floor(row_max) + 1, lane_int(batch->grid_size.y - 1)), lane_int(-1));
+
+	*min_cell = Vec2Int(batch->grid_size.x, batch->grid_size.y);
+	*max_cell = Vec2Int(-1, -1);
+	for (int i = 0; i < lane_count; i++) {
+		min_cell->x = cells->min_x[i] < min_cell->x ? cells->min_x[i] : min_cell->x;
+		max_cell->x = cells->max_x[i] > max_cell->x ? cells->max_x[i] : max_cell->x;
+		min_cell->y = cells->min_y[i] < min_cell->y ? cells->min_y[i] : min_cell->y;
+		max_cell->y = cells->max_y[i] > max_cell->y ? cells->max_y[i] : max_cell->y;
+	}
+}
+
+template<int32 FixedTileCount>
+void lane_reset_game(const LaneBatch* batch, LaneGroup* group, int32 lane) {
+	group->score[lane] = 0;
+	group->level[lane] = 1;
+	group->lives[lane] = 2;
+	lane_reset_ball_and_paddle(group, lane, ball_base_speed);
+	lane_set_tile_health<FixedTileCount>(batch, group, lane, 1);
+}
+
+/**
+ * Write the observation for one lane (same layout as the batch observations)
+ */
+template<int32 FixedTileCount>
+void lane_write_observation(const LaneBatch* batch, const LaneGroup* group, int32 lane, float32* observation) {
+	observation[0] = group->paddle_pos_x[lane];
+	observation[1] = group->ball_pos.x[lane];
+	observation[2] = group->ball_pos.y[lane];
+	observation[3] = group->ball_vel.x[lane];
+	observation[4] = group->ball_vel.y[lane];
+
+	const int32 tile_count = lane_tile_count<FixedTileCount>(batch);
+	const LaneInt* tile_health = lane_tile_health(group);
+	float32 health_scale = 1.0f / (float32)group->level[lane];
+	for (int i = 0; i < tile_count; i++) {
+		observation[5 + i] = (float32)tile_health[i][lane] * health_scale;
+	}
+}
+
+/**
+ * Step every lane of a group by one frame (see simulate() in game.cpp)
+ * @param direction -1 to move the paddle left, 1 to move it right, 0 to stay still
+ */
+template<int32 FixedTileCount>
+void lane_simulate(const LaneBatch* batch, LaneGroup* group, float32 delta_time, LaneFloat direction) {
+	const int32 tile_count = lane_tile_count<FixedTileCount>(batch);
+	LaneInt* tile_health = lane_tile_health(group);
+	uint32* tile_alive = lane_tile_alive(group, tile_count);
+
+	//
+	// Paddle Movement
+	//
+	{
+		LaneFloat delta_x = direction * paddle_speed * delta_time;
+
+		// Prevent movement if we would collide with the ball
+		LaneVec2 ball_end = { group->ball_pos.x - delta_x, group->ball_pos.y };
+		LaneVec2 paddle_pos = { group->paddle_pos_x, lane_float(paddle_pos_y) };
+		LaneHit hit;
+		lane_moving_circle_to_rectangle_check(group->ball_pos, ball_end, ball_radius, paddle_pos, paddle_size, lane_int(-1), &hit);
+		group->paddle_pos_x = lane_select(hit.mask, group->paddle_pos_x, group->paddle_pos_x + delta_x);
+
+		float32 max_pos_x = (world_size.x * 0.5f);
+		group->paddle_pos_x = lane_select(group->paddle_pos_x > max_pos_x, lane_float(max_pos_x), group->paddle_pos_x);
+		group->paddle_pos_x = lane_select(group->paddle_pos_x < -max_pos_x, lane_float(-max_pos_x), group->paddle_pos_x);
+	}
+
+	//
+	// Ball Movement And Collision
+	//
+	{
+		LaneVec2 old_ball_pos = group->ball_pos;
+		LaneVec2 new_ball_pos = {
+			group->ball_pos.x + group->ball_vel.x * delta_time,
+			group->ball_pos.y + group->ball_vel.y * delta_time
+		};
+
+		LaneFloat remaining_distance = lane_magnitude(new_ball_pos.x - old_ball_pos.x, new_ball_pos.y - old_ball_pos.y);
+
+		// Same iteration limit as the scalar version
+		for (int iteration = 1; iteration < 5; iteration++) {
+			LaneInt active = remaining_distance > 0.0f;
+			uint32 active_bits = lane_bits(active);
+			if (active_bits == 0) {
+				break;
+			}
+
+			LaneHit closest = lane_no_hit();
+
+			LaneHit hit;
+
+			// Right, left and top walls
+			lane_moving_circle_to_vertical_line_check(old_ball_pos, new_ball_pos, ball_radius, world_size.x * 0.5f, &hit);
+			lane_take_hit(&closest, &hit, hit.mask & (hit.distance < closest.distance));
+
+			lane_moving_circle_to_vertical_line_check(old_ball_pos, new_ball_pos, ball_radius, -world_size.x * 0.5f, &hit);
+			lane_take_hit(&closest, &hit, hit.mask & (hit.distance < closest.distance));
+
+			lane_moving_circle_to_horizontal_line_check(old_ball_pos, new_ball_pos, ball_radius, world_size.y * 0.5f, &hit);
+			lane_take_hit(&closest, &hit, hit.mask & (hit.distance < closest.distance));
+
+			// Paddle
+			LaneVec2 paddle_pos = { group->paddle_pos_x, lane_float(paddle_pos_y) };
+			lane_moving_circle_to_rectangle_check(old_ball_pos, new_ball_pos, ball_radius, paddle_pos, paddle_size, active, &hit);
+			LaneInt hit_paddle = hit.mask & (hit.distance < closest.distance);
+			lane_take_hit(&closest, &hit, hit_paddle);
+
+			// Tiles, skipping them all if no ball can reach the tile area, then only the cells within reach
+			// of any ball, testing each tile in the lanes it's within reach of and still has health in
+			LaneInt hit_tile = lane_int(-1);
+			LaneInt near_tiles = active
+					& ((old_ball_pos.y + ball_radius >= batch->tile_min.y) | (new_ball_pos.y + ball_radius >= batch->tile_min.y))
+					& ((old_ball_pos.y - ball_radius <= batch->tile_max.y) | (new_ball_pos.y - ball_radius <= batch->tile_max.y));
+			LaneCells cells;
+			Vec2Int min_cell = Vec2Int(0, 0);
+			Vec2Int max_cell = Vec2Int(-1, -1);
+			if (lane_bits(near_tiles) != 0) {
+				lane_tiles_in_reach(batch, old_ball_pos, new_ball_pos, near_tiles, &cells, &min_cell, &max_cell);
+			}
+			for (int y = min_cell.y; y <= max_cell.y; y++) {
+				uint32 row_bits = lane_bits((cells.min_y <= y) & (cells.max_y >= y));
+				for (int x = min_cell.x; x <= max_cell.x; x++) {
+					int32 i = y * batch->grid_size.x + x;
+					uint32 tile_lanes = tile_alive[i] & row_bits;
+					if (tile_lanes == 0) {
+						continue;
+					}
+					tile_lanes &= lane_bits((cells.min_x <= x) & (cells.max_x >= x));
+					if (tile_lanes == 0) {
+						continue;
+					}
+
+					LaneVec2 tile_pos = { lane_float(batch->tile_pos[i].x), lane_float(batch->tile_pos[i].y) };
+					lane_moving_circle_to_rectangle_check(old_ball_pos, new_ball_pos, ball_radius, tile_pos, batch->tile_size,
+							lane_mask(tile_lanes), &hit);
+
+					LaneInt closer = hit.mask & (hit.distance < closest.distance);
+					lane_take_hit(&closest, &hit, closer);
+					hit_tile = lane_select(closer, lane_int(i), hit_tile);
+					hit_paddle &= ~closer;
+				}
+			}
+
+			// Lanes with a collision before the end of the move
+			LaneInt collided = active & closest.mask & (closest.distance < remaining_distance);
+			remaining_distance = lane_select(active & ~collided, lane_float(0.0f), remaining_distance);
+
+			uint32 collided_bits = lane_bits(collided);
+			if (collided_bits == 0) {
+				continue;
+			}
+
+			remaining_distance = lane_select(collided, remaining_distance - closest.distance, remaining_distance);
+
+			// Reflect
+			LaneFloat vel_dot_normal = group->ball_vel.x * closest.normal.x + group->ball_vel.y * closest.normal.y;
+			LaneFloat reflect_x = group->ball_vel.x - 2.0f * vel_dot_normal * closest.normal.x;
+			LaneFloat reflect_y = group->ball_vel.y - 2.0f * vel_dot_normal * closest.normal.y;
+			group->ball_vel.x = lane_select(collided, reflect_x, group->ball_vel.x);
+			group->ball_vel.y = lane_select(collided, reflect_y, group->ball_vel.y);
+
+			// Paddle rotation and tile damage differ per lane and are rare, so handle them one lane at a time
+			uint32 paddle_bits = lane_bits(collided & hit_paddle & (closest.normal.y > 0.99f));
+			uint32 tile_bits = lane_bits(collided & (hit_tile >= 0));
+			for (int lane = 0; lane < lane_count; lane++) {
+				if (paddle_bits & (1u << lane)) {
+					float32 rotation = ((group->paddle_pos_x[lane] - closest.point.x[lane]) / paddle_size.x) * 2.0f * ball_paddle_max_rotation;
+					Vec2 vel = rotate(Vec2(group->ball_vel.x[lane], group->ball_vel.y[lane]), rotation);
+					group->ball_vel.x[lane] = vel.x;
+					group->ball_vel.y[lane] = vel.y;
+				}
+
+				if (tile_bits & (1u << lane)) {
+					int32 tile = hit_tile[lane];
+					tile_health[tile][lane]--;
+					if (tile_health[tile][lane] < 1) {
+						tile_alive[tile] &= ~(1u << lane);
+					}
+					group->score[lane]++;
+				}
+			}
+
+			LaneFloat vel_mag = lane_magnitude(group->ball_vel.x, group->ball_vel.y);
+			old_ball_pos.x = lane_select(collided, closest.point.x, old_ball_pos.x);
+			old_ball_pos.y = lane_select(collided, closest.point.y, old_ball_pos.y);
+			new_ball_pos.x = lane_select(collided, closest.point.x + (group->ball_vel.x / vel_mag) * remaining_distance, new_ball_pos.x);
+			new_ball_pos.y = lane_select(collided, closest.point.y + (group->ball_vel.y / vel_mag) * remaining_distance, new_ball_pos.y);
+		}
+
+		// Update ball pos
+		group->ball_pos = new_ball_pos;
+	}
+
+	//
+	// Check Advance Level
+	//
+	{
+		uint32 has_health = 0;
+		for (int i = 0; i < tile_count; i++) {
+			has_health |= tile_alive[i];
+		}
+
+		for (int lane = 0; lane < lane_count; lane++) {
+			if (has_health & (1u << lane)) {
+				continue;
+			}
+
+			group->level[lane]++;
+			lane_reset_ball_and_paddle(group, lane, ball_base_speed + ball_level_speed * (group->level[lane] - 1));
+			lane_set_tile_health<FixedTileCount>(batch, group, lane, group->level[lane]);
+		}
+	}
+}
+
+Game::LaneBatch* Game::init_lanes(int32 count, uint32 seed, Vec2Int grid_size) {
+	LaneBatch* batch = new LaneBatch;
+	batch->count = count;
+	batch->grid_size = grid_size;
+	batch->tile_count = grid_size.x * grid_size.y;
+	batch->tile_size = grid_fit_tile_size(grid_size);
+	batch->tile_pos = new Vec2[batch->tile_count];
+	batch->tile_min = Vec2(INFINITY, INFINITY);
+	batch->tile_max = Vec2(-INFINITY, -INFINITY);
+	for (int i = 0; i < batch->tile_count; i++) {
+		Vec2 pos = grid_tile_position(grid_size, batch->tile_size, i);
+		batch->tile_pos[i] = pos;
+		batch->tile_min.x = fmin(batch->tile_min.x, pos.x - batch->tile_size.x * 0.5f);
+		batch->tile_min.y = fmin(batch->tile_min.y, pos.y - batch->tile_size.y * 0.5f);
+		batch->tile_max.x = fmax(batch->tile_max.x, pos.x + batch->tile_size.x * 0.5f);
+		batch->tile_max.y = fmax(batch->tile_max.y, pos.y + batch->tile_size.y * 0.5f);
+	}
+
+	// Zeroed so every tile starts out dead in every lane
+	batch->group_count = (count + lane_count - 1) / lane_count;
+	batch->group_stride = lane_group_stride(batch->tile_count);
+	uint64 groups_size = (uint64)batch->group_count * batch->group_stride;
+	batch->groups = (uint8*)::operator new(groups_size, std::align_val_t(64));
+	memset(batch->groups, 0, groups_size);
+
+	for (int g = 0; g < batch->group_count; g++) {
+		LaneGroup* group = lane_group(batch, g);
+		for (int lane = 0; lane < lane_count; lane++) {
+			// Same seeds as init_batch() so the games match
+			uint32 random_state = seed + (uint32)(g * lane_count + lane) * 0x9E3779B9u;
+			group->random_state[lane] = random_state != 0 ? random_state : 1;
+			lane_reset_game<0>(batch, group, lane);
+		}
+	}
+
+	return batch;
+}
+
+void Game::free_lanes(LaneBatch* batch) {
+	::operator delete(batch->groups, std::align_val_t(64));
+	delete[] batch->tile_pos;
+	delete batch;
+}
+
+void Game::reset_lanes(LaneBatch* batch, float32* observations) {
+	const int32 observation_size = batch_observation_size(batch->grid_size);
+	for (int i = 0; i < batch->count; i++) {
+		LaneGroup* group = lane_group(batch, i / lane_count);
+		lane_reset_game<0>(batch, group, i % lane_count);
+		lane_write_observation<0>(batch, group, i % lane_count, observations + i * observation_size);
+	}
+}
+
+/**
+ * Step every group of a batch (see step_lanes())
+ */
+template<int32 FixedTileCount>
+void step_lane_groups(LaneBatch* batch, float64 delta_time, const uint8* actions,
+		float32* observations, float32* rewards, uint8* dones)
+{
+	const int32 observation_size = batch_observation_size(batch->grid_size);
+	for (int g = 0; g < batch->group_count; g++) {
+		LaneGroup* group = lane_group(batch, g);
+		int32 first = g * lane_count;
+		int32 lanes_used = batch->count - first < lane_count ? batch->count - first : lane_count;
+
+		LaneFloat direction = lane_float(0.0f);
+		for (int lane = 0; lane < lanes_used; lane++) {
+			uint8 action = actions[first + lane];
+			direction[lane] = action == 1 ? -1.0f : (action == 2 ? 1.0f : 0.0f);
+		}
+
+		LaneInt score = group->score;
+		lane_simulate<FixedTileCount>(batch, group, (float32)delta_time, direction);
+
+		//
+		// Check Game Over
+		//
+		for (int lane = 0; lane < lane_count; lane++) {
+			int32 reward = group->score[lane] - score[lane];
+			bool done = false;
+			if (group->ball_pos.y[lane] < -world_size.y * 0.5f) {
+				if (group->lives[lane] > 0) {
+					group->lives[lane]--;
+					lane_reset_ball_and_paddle(group, lane, ball_base_speed + ball_level_speed * (group->level[lane] - 1));
+				} else {
+					lane_reset_game<FixedTileCount>(batch, group, lane);
+					done = true;
+				}
+			}
+
+			if (lane < lanes_used) {
+				int32 index = first + lane;
+				rewards[index] = (float32)reward;
+				dones[index] = done ? 1 : 0;
+				lane_write_observation<FixedTileCount>(batch, group, lane, observations + index * observation_size);
+			}
+		}
+	}
+}
+
+void Game::step_lanes(LaneBatch* batch, float64 delta_time, const uint8* actions,
+		float32* observations, float32* rewards, uint8* dones)
+{
+	// The default grid gets tile loops with a bound known at compile time
+	if (batch->tile_count == default_tile_count) {
+		step_lane_groups<default_tile_count>(batch, delta_time, actions, observations, rewards, dones);
+	} else {
+		step_lane_groups<0>(batch, delta_time, actions, observations, rewards, dones);
+	}
+}
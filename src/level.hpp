@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string.h>
+#include "types.hpp"
+#include "vector.hpp"
+#include "game.hpp"
+
+/**
+ * Binary level files.
+ *
+ * The tiles in a level file are stored exactly like the game keeps them in
+ * memory, so loading a level is a single copy out of the mapped file with no
+ * parsing, however many tiles there are. Only the header and the tiles up to
+ * the first one that can be broken are checked when a level is opened, a level
+ * of millions of tiles opens instantly and its pages are read from disk as the
+ * copy touches them.
+ *
+ * File layout: LevelHeader, then tile_count Tiles starting at tiles_offset
+ * (a multiple of level_tiles_alignment).
+ *
+ * Grid levels place tile i at column i % grid_size_x and row i / grid_size_x
+ * (see grid_tile_position()) so the game can find the tiles near the ball by
+ * position, cells without a tile have a base health of 0. Levels with
+ * LEVEL_FREE_POSITIONS put tiles anywhere and every tile is tested.
+ */
+
+const uint32 level_magic           = 0x4C564C42; // "BLVL"
+const uint32 level_version         = 1;
+const uint64 level_tiles_alignment = 64;
+
+enum LevelFlags {
+	LEVEL_FREE_POSITIONS = 1 << 0 // Tiles aren't laid out on the grid
+};
+
+enum TileType {
+	TILE_NORMAL,
+	TILE_INDESTRUCTIBLE, // Bounces the ball but never breaks, the level is cleared without it
+	TILE_TYPE_COUNT
+};
+
+/**
+ * A tile both in level files and in the game's tile storage
+ */
+struct Tile {
+	Vec2   pos;         // Center in world units
+	int32  health;      // Hits left, level files store the base health here
+	uint16 base_health; // Health on level 1, multiplied by the level number when the tiles are refilled
+	uint16 type;        // TileType
+};
+
+static_assert(sizeof(Tile) == 16, "Tiles are stored in level files as they are in memory");
+
+struct LevelHeader {
+	uint32  magic;
+	uint32  version;
+	uint64  file_size;
+	int32   grid_size_x;  // Columns
+	int32   grid_size_y;  // Rows
+	int32   tile_count;   // grid_size_x * grid_size_y for grid levels
+	uint32  flags;        // LevelFlags
+	float32 tile_size_x;  // World units
+	float32 tile_size_y;
+	uint64  tiles_offset; // From the start of the file
+};
+
+// Read only view of a level file
+struct Level {
+	const LevelHeader* header;
+	const Tile*        tiles;
+};
+
+/**
+ * Size of a level file with the given number of tiles
+ */
+inline uint64 level_file_size(int32 tile_count) {
+	uint64 tiles_offset = (sizeof(LevelHeader) + level_tiles_alignment - 1) / level_tiles_alignment * level_tiles_alignment;
+	return tiles_offset + (uint64)tile_count * sizeof(Tile);
+}
+
+/**
+ * Fill out the header of a level file of level_file_size(tile_count) bytes, the tiles go right after it at tiles_offset
+ */
+inline void init_level_header(LevelHeader* header, Vec2Int grid_size, int32 tile_count, uint32 flags, Vec2 tile_size) {
+	memset(header, 0, sizeof(LevelHeader));
+	header->magic = level_magic;
+	header->version = level_version;
+	header->file_size = level_file_size(tile_count);
+	header->grid_size_x = grid_size.x;
+	header->grid_size_y = grid_size.y;
+	header->tile_count = tile_count;
+	header->flags = flags;
+	header->tile_size_x = tile_size.x;
+	header->tile_size_y = tile_size.y;
+	header->tiles_offset = header->file_size - (uint64)tile_count * sizeof(Tile);
+}
+
+/**
+ * Point a level at its file contents and check the header (the tiles are used as they are),
+ * levels with more than Game::max_grid_tile_count tiles or no tile that can be broken are rejected
+ * @param memory Must be aligned to level_tiles_alignment, which mapped files always are
+ * @returns False if the memory isn't a valid level
+ */
+inline bool level_init(Level* level, const uint8* memory, uint64 size) {
+	if (memory == NULL || size < sizeof(LevelHeader)) {
+		return false;
+	}
+
+	const LevelHeader* header = (const LevelHeader*)memory;
+	if (header->magic != level_magic || header->version != level_version || header->file_size != size) {
+		return false;
+	}
+
+	bool free_positions = (header->flags & LEVEL_FREE_POSITIONS) != 0;
+	if (header->tile_count < 0 || header->tile_count > Game::max_grid_tile_count || header->grid_size_x <= 0 || header->grid_size_y <= 0
+			|| (!free_positions && (int64)header->grid_size_x * header->grid_size_y != header->tile_count)
+			|| !(header->tile_size_x > 0.0f) || !(header->tile_size_y > 0.0f)) {
+		return false;
+	}
+
+	if (header->tiles_offset % level_tiles_alignment != 0 || header->tiles_offset < sizeof(LevelHeader)
+			|| header->tiles_offset > size || (size - header->tiles_offset) / sizeof(Tile) < (uint64)header->tile_count) {
+		return false;
+	}
+
+	// A level without a tile to break would be cleared as soon as it starts
+	const Tile* tiles = (const Tile*)(memory + header->tiles_offset);
+	int32 first_breakable = 0;
+	while (first_breakable < header->tile_count 
+			&& (tiles[first_breakable].type != TILE_NORMAL || tiles[first_breakable].base_health == 0)) {
+		first_breakable++;
+	}
+	if (first_breakable == header->tile_count) {
+		return false;
+	}
+
+	level->header = header;
+	level->tiles = tiles;
+	return true;
+}
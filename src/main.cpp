@@ -1,10 +1,18 @@
+#include <chrono>
 #include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 // External defines: 
 // - VERSION: String with version number (ex. "v1.0")
 // - WINDOWS: True if windows build
 // - MACOS: True if mac build
+// - PROFILER: Compile in the profiler markers (see profiler.hpp)
+// - EMBED_ASSETS: Assets are compiled into the executable (see assetpack.hpp)
+// - ALLOC_TRACKING: Count heap allocations and check the frame loop doesn't make any (see alloctrack.hpp)
 
 #ifndef VERSION
 #define VERSION "Unknown Version"
@@ -18,11 +26,90 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "alloctrack.hpp"
+#include "arena.hpp"
+#include "assetpack.hpp"
 #include "game.hpp"
+#include "level.hpp"
+#include "mappedfile.hpp"
+#include "metrics.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "startuptrace.hpp"
+#include "stats.hpp"
+#include "timer.hpp"
+
+#ifndef WINDOWS
+#include "agentlink.hpp"
+#endif
 
 GLFWwindow* window;
 Game::Input game_input;
 
+const uint64 frame_arena_size = 8 * 1024 * 1024;
+const char*  asset_pack_path  = "assets.pack"; // Relative to the executable directory
+
+// Nanosecond timings of every frame for the session
+struct FrameStats {
+	Histogram frame;  // Start of one frame to the start of the next
+	Histogram update; // Game::update() and the autopilot
+	Histogram render; // Game::render()
+	Histogram swap;   // Waiting on glfwSwapBuffers() (v-sync)
+};
+
+FrameStats frame_stats;
+
+void reset_frame_stats() {
+	histogram_reset(&frame_stats.frame);
+	histogram_reset(&frame_stats.update);
+	histogram_reset(&frame_stats.render);
+	histogram_reset(&frame_stats.swap);
+}
+
+// Physics counters at the last report (see physics_metrics_report())
+PhysicsCounters physics_metrics_previous[physics_metrics_level_count];
+float64 physics_metrics_interval = 0.0; // Seconds between reports, 0 to only report on exit
+
+// Heap allocations made in each part of the frame once allocation tracking is armed
+struct FrameAllocations {
+	uint64 update; // Game::update() and the autopilot
+	uint64 render; // Game::render()
+	uint64 other;  // Everything else in the frame loop (events, swap, replay, stats)
+	uint64 frames; // Frames counted
+	uint64 frames_with_allocations;
+};
+
+FrameAllocations frame_allocations;
+const int32 alloc_tracking_warmup_frames = 120; // Frames before arming, buffers created on first use may allocate until then
+bool alloc_tracking_strict = false;
+
+/**
+ * Add the allocations of a frame given the allocation counts at the start of each part
+ */
+void record_frame_allocations(uint64 frame_start, uint64 update_start, uint64 render_start, uint64 render_end, uint64 frame_end) {
+	frame_allocations.update += render_start - update_start;
+	frame_allocations.render += render_end - render_start;
+	frame_allocations.other += (update_start - frame_start) + (frame_end - render_end);
+	frame_allocations.frames++;
+	frame_allocations.frames_with_allocations += frame_end != frame_start;
+}
+
+void print_frame_allocations() {
+	#ifdef ALLOC_TRACKING
+	std::cout << "Heap allocations after warmup: " << frame_allocations.frames_with_allocations << " of " 
+			<< frame_allocations.frames << " frames allocated (update " << frame_allocations.update 
+			<< ", render " << frame_allocations.render << ", rest of frame " << frame_allocations.other 
+			<< "), " << alloc_tracking_violation_count() << " no-allocation violations" << std::endl;
+	#endif
+}
+
+void print_frame_stats() {
+	histogram_print(&frame_stats.frame, "Frame");
+	histogram_print(&frame_stats.update, "Update");
+	histogram_print(&frame_stats.render, "Render");
+	histogram_print(&frame_stats.swap, "Swap");
+}
+
 void error_glfw_callback(int error, const char* description) {
 	std::cerr << "Error: " << description << std::endl;
 }
@@ -42,14 +129,205 @@ void update_ui(int32 score, int32 lives, const char* info) {
 	glfwSetWindowTitle(window, window_title);
 }
 
+/**
+ * Let the autopilot play headless for the given number of seconds and report how fast it decides.
+ * Used as a soak benchmark since every decision runs the game update many times over.
+ * @returns Process exit code
+ */
+int run_soak(float64 seconds, Vec2Int grid_size) {
+	float64 next_metrics_report = physics_metrics_interval;
+
+	Game::Data* game_data = Game::init_headless(grid_size);
+	Game::Autopilot* autopilot = Game::create_autopilot(0);
+
+	Game::Input input = {};
+	input.delta_time = 1.0 / 60.0;
+
+	reset_frame_stats();
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	float64 elapsed = 0.0;
+	float64 next_report = 1.0;
+	int64 frame_count = 0;
+
+	while (elapsed < seconds) {
+		// Tap start whenever the game is waiting for it
+		Game::Observation observation;
+		Game::observe(game_data, &observation);
+		input.start_key_pressed_prev = input.start_key_pressed;
+		input.start_key_pressed = observation.state != 1 && !input.start_key_pressed_prev;
+
+		if (frame_count == alloc_tracking_warmup_frames) {
+			alloc_tracking_arm(alloc_tracking_strict);
+		}
+
+		uint64 allocations_start = thread_allocation_counts().count;
+		uint64 frame_start = timer_nanoseconds();
+		Game::autopilot_decide(autopilot, game_data, &input);
+		input.frame_time += input.delta_time;
+		uint64 update_start = timer_nanoseconds();
+		Game::update(&input, game_data);
+		uint64 frame_end = timer_nanoseconds();
+		uint64 allocations_end = thread_allocation_counts().count;
+		histogram_record(&frame_stats.frame, frame_end - frame_start);
+		histogram_record(&frame_stats.update, frame_end - update_start);
+		if (frame_count >= alloc_tracking_warmup_frames) {
+			record_frame_allocations(allocations_start, allocations_start, allocations_end, allocations_end, allocations_end);
+		}
+		frame_count++;
+
+		elapsed = std::chrono::duration<float64>(std::chrono::steady_clock::now() - start_time).count();
+		if (elapsed >= next_report) {
+			std::cout << "Soak " << (int)elapsed << "s: " << Game::autopilot_decisions_per_second(autopilot)
+					<< " decisions/s, score " << observation.score << ", level " << observation.level << std::endl;
+			next_report += 1.0;
+		}
+
+		if (physics_metrics_interval > 0.0 && elapsed >= next_metrics_report) {
+			physics_metrics_report(physics_metrics_previous);
+			next_metrics_report += physics_metrics_interval;
+		}
+	}
+
+	std::cout << "Soak finished after " << frame_count << " frames: "
+			<< Game::autopilot_decisions_per_second(autopilot) << " decisions/s" << std::endl;
+	histogram_print(&frame_stats.frame, "Decide+Update");
+	histogram_print(&frame_stats.update, "Update");
+	physics_metrics_report(physics_metrics_previous);
+	print_frame_allocations();
+
+	Game::free_autopilot(autopilot);
+	Game::free_headless(game_data);
+	return 0;
+}
+
 /**
  * Program entry point
+ * 
+ * Arguments:
+ * - --agent <name>: Run headless and let an external agent step the game
+ *   through the named shared memory object (see agentlink.hpp)
+ * - --autopilot: Let the computer move the paddle
+ * - --level <path>: Play a level file (see level.hpp) instead of the built-in level
+ * - --grid <columns>x<rows>: Size of the tile grid of the built-in level (default 12x3),
+ *   also used by --agent and --soak
+ * - --soak <seconds>: Run headless with the autopilot playing and report decisions per second
+ * - --profile <path>: Record profiler markers and write them as Chrome trace JSON on exit
+ *   (relative to the executable directory when running with a window, unless built with EMBED_ASSETS)
+ * - --spike-budget <ms>: Frame time that saves a replay of the last few seconds
+ *   when exceeded (default 50, 0 only saves on hitting the max collision iterations),
+ *   only on the built-in level with the default grid
+ * - --replay <path>: Play a saved replay headless and report update times
+ * - --metrics <seconds>: Print physics counters at this interval as well as on exit
+ * - --shader-cache <directory>: Where linked shader programs are cached (default shader_cache
+ *   next to the executable, builds with EMBED_ASSETS only cache when this is given)
+ * - --no-shader-cache: Always compile the shader programs
+ * - --huge-pages: Try to back the permanent game memory with huge pages
+ * - --alloc-strict: Abort on a heap allocation in the frame loop once warmed up (needs -DALLOC_TRACKING)
  */
-int main() {
+int main(int argc, char** argv) {
+	startup_trace_begin();
 
 	std::cout << "Starting..." << std::endl;
 
-	// Set working directory to be the directory the executable is in.
+	const char* agent_link_name = NULL;
+	bool autopilot_enabled = false;
+	const char* level_path = NULL;
+	Vec2Int grid_size = Vec2Int(Game::default_grid_size_x, Game::default_grid_size_y);
+	float64 soak_seconds = 0.0;
+	const char* profile_path = NULL;
+	const char* replay_path = NULL;
+	float64 spike_budget_ms = 50.0;
+	bool huge_pages = false;
+	#ifdef EMBED_ASSETS
+	const char* shader_cache_directory = NULL;
+	#else
+	const char* shader_cache_directory = "shader_cache";
+	#endif
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--agent") == 0 && i + 1 < argc) {
+			agent_link_name = argv[++i];
+		} else if (strcmp(argv[i], "--autopilot") == 0) {
+			autopilot_enabled = true;
+		} else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+			level_path = argv[++i];
+		} else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+			Vec2Int parsed_size;
+			if (sscanf(argv[++i], "%dx%d", &parsed_size.x, &parsed_size.y) == 2 && parsed_size.x > 0 && parsed_size.y > 0
+					&& (int64)parsed_size.x * parsed_size.y <= Game::max_grid_tile_count) {
+				grid_size = parsed_size;
+			} else {
+				std::cout << "Ignoring invalid grid size: " << argv[i] << std::endl;
+			}
+		} else if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc) {
+			soak_seconds = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+			profile_path = argv[++i];
+		} else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replay_path = argv[++i];
+		} else if (strcmp(argv[i], "--spike-budget") == 0 && i + 1 < argc) {
+			spike_budget_ms = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+			physics_metrics_interval = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+			shader_cache_directory = argv[++i];
+		} else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+			shader_cache_directory = NULL;
+		} else if (strcmp(argv[i], "--huge-pages") == 0) {
+			huge_pages = true;
+		} else if (strcmp(argv[i], "--alloc-strict") == 0) {
+			alloc_tracking_strict = true;
+		}
+	}
+
+	if (profile_path != NULL) {
+		#ifndef PROFILER
+		std::cout << "Profiler markers are not compiled in, build with -DPROFILER to record them." << std::endl;
+		#endif
+		profiler_start();
+	}
+
+	#ifndef ALLOC_TRACKING
+	if (alloc_tracking_strict) {
+		std::cout << "Allocation tracking is not compiled in, build with -DALLOC_TRACKING to check allocations." << std::endl;
+	}
+	#endif
+
+	if (soak_seconds > 0.0 || replay_path != NULL) {
+		int result = replay_path != NULL ? replay_run(replay_path) : run_soak(soak_seconds, grid_size);
+		if (profile_path != NULL) {
+			profiler_stop();
+			profiler_write_trace(profile_path);
+		}
+		return result;
+	}
+
+	if (agent_link_name != NULL) {
+		#ifdef WINDOWS
+		std::cout << "Agent mode is not supported on Windows." << std::endl;
+		return 1;
+		#else
+		return agent_link_serve(agent_link_name, grid_size);
+		#endif
+	}
+
+	// Map the level before changing the working directory so relative paths work,
+	// the game memory is sized for its tiles
+	MappedFile level_file = {};
+	Level level;
+	int32 tile_capacity = 0;
+	if (level_path != NULL) {
+		if (!map_file(level_path, &level_file) || !level_init(&level, level_file.memory, level_file.size)) {
+			std::cout << "Not a valid level file: " << level_path << std::endl;
+			unmap_file(&level_file);
+			return 1;
+		}
+		tile_capacity = level.header->tile_count;
+	}
+
+	// Set working directory to be the directory the executable is in so assets.pack is found.
+	// Embedded builds don't load anything from disk and run from any working directory.
+	#ifndef EMBED_ASSETS
 	uint32 exec_path_size = 1024;
 	char exec_path[exec_path_size];
 
@@ -63,6 +341,8 @@ int main() {
 
 	chdir(exec_path);
 	std::cout << "Working Directory: " << exec_path << std::endl;
+	#endif
+	startup_trace_mark("Working directory");
 
 	//
 	// GLFW Window setup
@@ -73,6 +353,7 @@ int main() {
 		std::cout << "Failed to initialize glfw." << std::endl;
 		return 1;
 	}
+	startup_trace_mark("glfwInit");
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -96,21 +377,56 @@ int main() {
 
 	// Enable V-sync
 	glfwSwapInterval(1);
+	startup_trace_mark("Window creation");
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 		std::cout << "Failed to initialize GLAD." << std::endl;
 		glfwTerminate();
 		return 1;
 	}
+	startup_trace_mark("gladLoadGLLoader");
 
 	//
 	// Initialize Game
 	//
+	Arena* permanent_arena = create_arena(Game::init_memory_size(grid_size, tile_capacity), huge_pages);
+	Arena* frame_arena = create_arena(frame_arena_size, false);
+	if (permanent_arena == NULL || frame_arena == NULL) {
+		std::cout << "Failed to allocate game memory." << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	if (huge_pages) {
+		std::cout << "Huge pages: " << (permanent_arena->huge_pages ? "on" : "not available") << std::endl;
+	}
+	startup_trace_mark("Memory arenas");
+
+	#ifdef EMBED_ASSETS
+	AssetPack* asset_pack = open_embedded_asset_pack();
+	#else
+	AssetPack* asset_pack = open_asset_pack(asset_pack_path);
+	#endif
+	if (asset_pack == NULL) {
+		glfwTerminate();
+		return 1;
+	}
+	startup_trace_mark("Asset pack");
+
 	game_input.delta_time        = 1.0 / 60.0;
 	game_input.left_key_pressed  = false;
 	game_input.right_key_pressed = true;
+	game_input.rewind_key_pressed = false;
+	game_input.show_trajectory    = false;
 	glfwGetFramebufferSize(window, &game_input.frame_buffer_size.x, &game_input.frame_buffer_size.y);
 	game_input.update_ui = update_ui;
+	game_input.trace_startup = startup_trace_mark;
+	game_input.permanent_arena = permanent_arena;
+	game_input.frame_arena = frame_arena;
+	game_input.assets = asset_pack;
+	game_input.grid_size = grid_size;
+	game_input.tile_capacity = tile_capacity;
+	game_input.get_gl_proc_address = (GLADloadproc)glfwGetProcAddress;
+	game_input.shader_cache_directory = shader_cache_directory;
 
 	Game::Data* game_data = Game::init(&game_input);
 	if (game_data == NULL) {
@@ -118,13 +434,63 @@ int main() {
 		glfwTerminate();
 		return -1;
 	}
+
+	if (level_path != NULL) {
+		// The tiles are copied out, so the file isn't needed after
+		bool level_loaded = Game::load_level(game_data, &level);
+		unmap_file(&level_file);
+		if (!level_loaded) {
+			glfwTerminate();
+			return 1;
+		}
+		startup_trace_mark("Level");
+	}
+
+	Game::Autopilot* autopilot = NULL;
+	if (autopilot_enabled) {
+		autopilot = Game::create_autopilot(0);
+	}
+	startup_trace_mark("Autopilot");
 	
 	//
 	// Game Loop
 	//
 	float64 prev_frame_time = glfwGetTime();
+	bool trajectory_key_pressed_prev = false;
+	bool stats_key_pressed_prev = false;
+
+	reset_frame_stats();
+	uint64 prev_frame_start = 0;
+
+	// Replays only play back on the built-in level (see replay.hpp), so other levels aren't recorded
+	bool default_level = level_path == NULL && grid_size.x == Game::default_grid_size_x && grid_size.y == Game::default_grid_size_y;
+	ReplayRecorder* replay_recorder = default_level ? create_replay_recorder(game_data) : NULL;
+	uint64 spike_budget_ns = (uint64)(spike_budget_ms * 1e6);
+	int64 session_time = (int64)time(NULL);
+	float64 next_metrics_report = glfwGetTime() + physics_metrics_interval;
+	int64 frame_count = 0;
+	Game::LoadState prev_load_state = Game::ASSETS_LOADING;
+	int exit_code = 0;
 	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
+		PROFILE_SCOPE("Frame");
+
+		if (frame_count == alloc_tracking_warmup_frames) {
+			alloc_tracking_arm(alloc_tracking_strict);
+		}
+		uint64 allocations_frame_start = thread_allocation_counts().count;
+
+		arena_reset(frame_arena);
+
+		uint64 frame_start = timer_nanoseconds();
+		if (prev_frame_start != 0) {
+			histogram_record(&frame_stats.frame, frame_start - prev_frame_start);
+		}
+		prev_frame_start = frame_start;
+
+		{
+			PROFILE_SCOPE("Poll Events");
+			glfwPollEvents();
+		}
 
 		// Time
 		float64 cur_frame_time = glfwGetTime();
@@ -149,15 +515,116 @@ int main() {
 		game_input.start_key_pressed_prev = game_input.start_key_pressed;
 		game_input.start_key_pressed = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
 
-		// Update and render the game
+		game_input.rewind_key_pressed = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+
+		bool trajectory_key_pressed = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+		if (trajectory_key_pressed && !trajectory_key_pressed_prev) {
+			game_input.show_trajectory = !game_input.show_trajectory;
+		}
+		trajectory_key_pressed_prev = trajectory_key_pressed;
+
+		bool stats_key_pressed = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+		if (stats_key_pressed && !stats_key_pressed_prev) {
+			print_frame_stats();
+		}
+		stats_key_pressed_prev = stats_key_pressed;
+
+		uint64 allocations_update_start = thread_allocation_counts().count;
+		uint64 update_start = timer_nanoseconds();
+		if (autopilot != NULL) {
+			Game::autopilot_decide(autopilot, game_data, &game_input);
+		}
+
+		// Update and render the game, replays start with the first frame the game runs (update() skips the loading frames, 
+		// which a replay played back without loading would run)
+		bool recording_replay = replay_recorder != NULL && Game::load_state(game_data) == Game::ASSETS_READY;
+		if (recording_replay) {
+			replay_record_frame(replay_recorder, game_data, &game_input);
+		}
 		Game::update(&game_input, game_data);
+		if (Game::collision_limit_hit(game_data)) {
+			std::cout << "Warning: Hit max collision iterations." << std::endl;
+		}
+
+		uint64 allocations_render_start = thread_allocation_counts().count;
+		uint64 render_start = timer_nanoseconds();
 		Game::render(&game_input, game_data);
-		glfwSwapBuffers(window);
+		uint64 allocations_render_end = thread_allocation_counts().count;
+
+		uint64 swap_start = timer_nanoseconds();
+		{
+			PROFILE_SCOPE("Swap Buffers");
+			glfwSwapBuffers(window);
+		}
+		uint64 swap_end = timer_nanoseconds();
+
+		// The first frames show a loading screen while the assets load in the background
+		Game::LoadState load_state = Game::load_state(game_data);
+		if (frame_count == 0) {
+			startup_trace_mark("First frame");
+		}
+		if (load_state != prev_load_state && load_state == Game::ASSETS_READY) {
+			startup_trace_mark("First game frame");
+			startup_trace_report();
+		}
+		prev_load_state = load_state;
+		if (load_state == Game::ASSETS_FAILED) {
+			std::cout << "Failed to load assets." << std::endl;
+			exit_code = -1;
+			break;
+		}
+
+		histogram_record(&frame_stats.update, render_start - update_start);
+		histogram_record(&frame_stats.render, swap_start - render_start);
+		histogram_record(&frame_stats.swap, swap_end - swap_start);
+
+		// Save what led up to a spike so it can be played back under a profiler
+		bool spike = spike_budget_ns > 0 && swap_end - frame_start > spike_budget_ns;
+		if (recording_replay && (spike || Game::collision_limit_hit(game_data)) && replay_can_dump(replay_recorder)) {
+			char replay_file[256];
+			snprintf(replay_file, sizeof(replay_file), "spike_%lld_%lld.replay", 
+					(long long)session_time, (long long)replay_recorder->frame_count);
+			replay_dump(replay_recorder, game_data, replay_file);
+		}
+
+		if (physics_metrics_interval > 0.0 && cur_frame_time >= next_metrics_report) {
+			physics_metrics_report(physics_metrics_previous);
+			next_metrics_report += physics_metrics_interval;
+		}
+
+		if (frame_count >= alloc_tracking_warmup_frames) {
+			record_frame_allocations(allocations_frame_start, allocations_update_start, allocations_render_start,
+					allocations_render_end, thread_allocation_counts().count);
+		}
+		frame_count++;
 	}
 
+	if (replay_recorder != NULL) {
+		free_replay_recorder(replay_recorder);
+	}
+
+	print_frame_stats();
+	physics_metrics_report(physics_metrics_previous);
+	print_frame_allocations();
+	std::cout << "Frame arena peak: " << frame_arena->peak << " of " << frame_arena->capacity << " bytes" << std::endl;
+
+	if (profile_path != NULL) {
+		profiler_stop();
+		profiler_write_trace(profile_path);
+	}
+
+	if (autopilot != NULL) {
+		std::cout << "Autopilot: " << Game::autopilot_decisions_per_second(autopilot) << " decisions/s" << std::endl;
+		Game::free_autopilot(autopilot);
+	}
+
+	close_asset_pack(asset_pack);
+	free_arena(frame_arena);
+	free_arena(permanent_arena);
+
 	glfwDestroyWindow(window);
 
 	glfwTerminate();
 
-	return 0;
+	return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "mappedfile.hpp"
+
+#ifdef WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool map_file(const char* path, MappedFile* file) {
+	file->memory = NULL;
+	file->size = 0;
+	file->file_handle = NULL;
+	file->mapping_handle = NULL;
+
+	#ifdef WINDOWS
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER file_size;
+	if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &file_size)) {
+		if (handle != INVALID_HANDLE_VALUE) {
+			CloseHandle(handle);
+		}
+		return false;
+	}
+
+	file->size = (uint64)file_size.QuadPart;
+	file->file_handle = handle;
+	if (file->size == 0) {
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	file->mapping_handle = mapping;
+	file->memory = mapping != NULL ? (const uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	#else
+	int handle = open(path, O_RDONLY);
+	struct stat file_stat;
+	if (handle < 0 || fstat(handle, &file_stat) != 0) {
+		if (handle >= 0) {
+			close(handle);
+		}
+		return false;
+	}
+
+	file->size = (uint64)file_stat.st_size;
+	if (file->size == 0) {
+		close(handle);
+		return true;
+	}
+
+	void* mapped = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, handle, 0);
+	file->memory = mapped != MAP_FAILED ? (const uint8*)mapped : NULL;
+
+	// The mapping stays valid after the file is closed
+	close(handle);
+	#endif
+
+	if (file->memory == NULL) {
+		unmap_file(file);
+		return false;
+	}
+	return true;
+}
+
+void unmap_file(MappedFile* file) {
+	#ifdef WINDOWS
+	if (file->memory != NULL) {
+		UnmapViewOfFile(file->memory);
+	}
+	if (file->mapping_handle != NULL) {
+		CloseHandle(file->mapping_handle);
+	}
+	if (file->file_handle != NULL) {
+		CloseHandle(file->file_handle);
+	}
+	#else
+	if (file->memory != NULL) {
+		munmap((void*)file->memory, file->size);
+	}
+	#endif
+
+	file->memory = NULL;
+	file->size = 0;
+	file->file_handle = NULL;
+	file->mapping_handle = NULL;
+}
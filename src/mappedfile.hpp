@@ -0,0 +1,24 @@
+#pragma once
+
+#include "types.hpp"
+
+/**
+ * Read only memory mapping of a whole file. Pages are only read from disk when
+ * they are first touched, so mapping a large file is instant and reading it
+ * streams it in without copying it through a buffer first.
+ */
+struct MappedFile {
+	const uint8* memory; // NULL for empty files
+	uint64       size;
+
+	void* file_handle;    // Platform handles of the mapping (see mappedfile.cpp)
+	void* mapping_handle;
+};
+
+/**
+ * Map a file into memory (remember to call unmap_file() after)
+ * @returns False if the file can't be opened or mapped
+ */
+bool map_file(const char* path, MappedFile* file);
+
+void unmap_file(MappedFile* file);
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include "metrics.hpp"
+
+struct PhysicsMetricsBlock {
+	std::atomic<uint64>  values[physics_metrics_level_count][PHYSICS_COUNTER_COUNT];
+	PhysicsMetricsBlock* next;
+};
+
+// Every thread that has added counters, only locked when a thread adds its first counters or collecting
+std::mutex           physics_metrics_mutex;
+PhysicsMetricsBlock* physics_metrics_blocks = NULL;
+
+thread_local PhysicsMetricsBlock* physics_metrics_thread_block = NULL;
+
+void physics_metrics_add(int32 level, const PhysicsCounters* counters) {
+	PhysicsMetricsBlock* block = physics_metrics_thread_block;
+	if (block == NULL) {
+		block = new PhysicsMetricsBlock;
+		for (int i = 0; i < physics_metrics_level_count; i++) {
+			for (int j = 0; j < PHYSICS_COUNTER_COUNT; j++) {
+				block->values[i][j].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(physics_metrics_mutex);
+		block->next = physics_metrics_blocks;
+		physics_metrics_blocks = block;
+		physics_metrics_thread_block = block;
+	}
+
+	int32 bucket = level < 1 ? 0 : (level > physics_metrics_level_count ? physics_metrics_level_count : level) - 1;
+	for (int i = 0; i < PHYSICS_COUNTER_COUNT; i++) {
+		// Only this thread writes the block, so there is no need for an atomic add
+		std::atomic<uint64>* value = &block->values[bucket][i];
+		value->store(value->load(std::memory_order_relaxed) + counters->values[i], std::memory_order_relaxed);
+	}
+}
+
+void physics_metrics_collect(PhysicsCounters* per_level) {
+	for (int i = 0; i < physics_metrics_level_count; i++) {
+		for (int j = 0; j < PHYSICS_COUNTER_COUNT; j++) {
+			per_level[i].values[j] = 0;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(physics_metrics_mutex);
+	for (PhysicsMetricsBlock* block = physics_metrics_blocks; block != NULL; block = block->next) {
+		for (int i = 0; i < physics_metrics_level_count; i++) {
+			for (int j = 0; j < PHYSICS_COUNTER_COUNT; j++) {
+				per_level[i].values[j] += block->values[i][j].load(std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+void physics_metrics_report(PhysicsCounters* previous) {
+	PhysicsCounters current[physics_metrics_level_count];
+	physics_metrics_collect(current);
+
+	bool has_frames = false;
+	for (int i = 0; i < physics_metrics_level_count; i++) {
+		has_frames |= current[i].values[PHYSICS_FRAMES] != previous[i].values[PHYSICS_FRAMES];
+	}
+	if (!has_frames) {
+		std::cout << "Physics: no frames simulated since the last report" << std::endl;
+		return;
+	}
+
+	std::cout << "Physics per frame: level, frames, collision iterations, narrowphase tests, broadphase rejections, tiles destroyed, collision limit hits" << std::endl;
+	for (int i = 0; i < physics_metrics_level_count; i++) {
+		uint64 delta[PHYSICS_COUNTER_COUNT];
+		for (int j = 0; j < PHYSICS_COUNTER_COUNT; j++) {
+			delta[j] = current[i].values[j] - previous[i].values[j];
+			previous[i].values[j] = current[i].values[j];
+		}
+
+		uint64 frames = delta[PHYSICS_FRAMES];
+		if (frames == 0) {
+			continue;
+		}
+
+		char line[256];
+		snprintf(line, sizeof(line), "  %2d%s %10llu  %6.3f  %7.3f  %7.3f  %8.5f  %llu",
+				i + 1, i == physics_metrics_level_count - 1 ? "+" : " ", (unsigned long long)frames,
+				delta[PHYSICS_COLLISION_ITERATIONS] / (float64)frames,
+				delta[PHYSICS_NARROWPHASE_TESTS] / (float64)frames,
+				delta[PHYSICS_BROADPHASE_REJECTIONS] / (float64)frames,
+				delta[PHYSICS_TILES_DESTROYED] / (float64)frames,
+				(unsigned long long)delta[PHYSICS_COLLISION_LIMIT_HITS]);
+		std::cout << line << std::endl;
+	}
+}
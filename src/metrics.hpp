@@ -0,0 +1,41 @@
+#pragma once
+
+#include "types.hpp"
+
+/**
+ * Counters for how much work the physics does, split by level.
+ *
+ * Every thread adds into its own block of counters so simulating on worker
+ * threads (ex. autopilot rollouts) never contends on a shared cache line or
+ * takes a lock. Only the owning thread writes a block, other threads just read
+ * it when collecting, so the counters are plain relaxed atomic loads and stores.
+ */
+
+enum PhysicsCounter {
+	PHYSICS_FRAMES,                // Frames simulated
+	PHYSICS_COLLISION_ITERATIONS,  // Passes of the ball collision loop
+	PHYSICS_COLLISION_LIMIT_HITS,  // Frames that hit the max collision iterations
+	PHYSICS_NARROWPHASE_TESTS,     // Exact moving circle to rectangle tests
+	PHYSICS_BROADPHASE_REJECTIONS, // Rectangles skipped by the quick check
+	PHYSICS_TILES_DESTROYED,
+	PHYSICS_COUNTER_COUNT
+};
+
+// Levels past this are counted together in the last level
+const int32 physics_metrics_level_count = 16;
+
+struct PhysicsCounters {
+	uint64 values[PHYSICS_COUNTER_COUNT];
+};
+
+// Add counters to the calling thread's block
+void physics_metrics_add(int32 level, const PhysicsCounters* counters);
+
+// Sum the counters of every thread, per_level must hold physics_metrics_level_count entries
+void physics_metrics_collect(PhysicsCounters* per_level);
+
+/**
+ * Print the counters gathered since the previous report.
+ * @param previous Counters at the previous report (physics_metrics_level_count entries, zeroed before the first report)
+ */
+void physics_metrics_report(PhysicsCounters* previous);
@@ -0,0 +1,141 @@
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include "profiler.hpp"
+
+struct ProfileEvent {
+	const char* name;
+	uint64      start_ns;
+	uint64      end_ns;
+};
+
+struct ProfileThreadBuffer {
+	ProfileEvent*        events; // Allocated on the first event so idle threads cost nothing
+	int32                event_count;
+	int32                dropped_count;
+	uint32               thread_id;
+	uint32               capture; // Capture the events belong to, older events are discarded
+	ProfileThreadBuffer* next;
+};
+
+std::atomic<bool>   profiler_recording(false);
+std::atomic<uint32> profiler_capture(0);
+uint64              profiler_start_ns = 0;
+
+// Every thread that has recorded a marker, only locked when a thread records its first marker
+std::mutex           profiler_threads_mutex;
+ProfileThreadBuffer* profiler_threads = NULL;
+uint32               profiler_thread_count = 0;
+
+thread_local ProfileThreadBuffer* profiler_thread_buffer = NULL;
+thread_local int32                profiler_mute_depth = 0;
+
+void profiler_start() {
+	profiler_start_ns = timer_nanoseconds();
+	profiler_capture.fetch_add(1, std::memory_order_relaxed);
+	profiler_recording.store(true, std::memory_order_release);
+}
+
+void profiler_stop() {
+	profiler_recording.store(false, std::memory_order_release);
+}
+
+bool profiler_is_recording() {
+	return profiler_recording.load(std::memory_order_relaxed);
+}
+
+void profiler_record(const char* name, uint64 start_ns, uint64 end_ns) {
+	if (!profiler_recording.load(std::memory_order_relaxed) || profiler_mute_depth > 0) {
+		return;
+	}
+
+	ProfileThreadBuffer* buffer = profiler_thread_buffer;
+	if (buffer == NULL) {
+		buffer = new ProfileThreadBuffer;
+		buffer->events = new ProfileEvent[profiler_thread_event_capacity];
+		buffer->event_count = 0;
+		buffer->dropped_count = 0;
+		buffer->capture = profiler_capture.load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(profiler_threads_mutex);
+		buffer->thread_id = profiler_thread_count++;
+		buffer->next = profiler_threads;
+		profiler_threads = buffer;
+		profiler_thread_buffer = buffer;
+	}
+
+	uint32 capture = profiler_capture.load(std::memory_order_relaxed);
+	if (buffer->capture != capture) {
+		buffer->capture = capture;
+		buffer->event_count = 0;
+		buffer->dropped_count = 0;
+	}
+
+	if (buffer->event_count >= profiler_thread_event_capacity) {
+		buffer->dropped_count++;
+		return;
+	}
+
+	ProfileEvent* event = &buffer->events[buffer->event_count++];
+	event->name = name;
+	event->start_ns = start_ns;
+	event->end_ns = end_ns;
+}
+
+void profiler_push_mute() {
+	profiler_mute_depth++;
+}
+
+void profiler_pop_mute() {
+	profiler_mute_depth--;
+}
+
+bool profiler_write_trace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		std::cout << "Failed to open trace file: " << path << std::endl;
+		return false;
+	}
+
+	uint32 capture = profiler_capture.load(std::memory_order_relaxed);
+	int64 event_count = 0;
+	int64 dropped_count = 0;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(profiler_threads_mutex);
+	for (ProfileThreadBuffer* buffer = profiler_threads; buffer != NULL; buffer = buffer->next) {
+		if (buffer->capture != capture) {
+			continue;
+		}
+
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+				first ? "" : ",\n", buffer->thread_id, buffer->thread_id);
+		first = false;
+
+		for (int32 i = 0; i < buffer->event_count; i++) {
+			ProfileEvent* event = &buffer->events[i];
+			// Chrome trace times are in microseconds
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					event->name, buffer->thread_id,
+					(int64)(event->start_ns - profiler_start_ns) / 1000.0,
+					(event->end_ns - event->start_ns) / 1000.0);
+		}
+
+		event_count += buffer->event_count;
+		dropped_count += buffer->dropped_count;
+	}
+
+	fprintf(file, "\n]}\n");
+	bool ok = ferror(file) == 0;
+	fclose(file);
+
+	std::cout << "Wrote " << event_count << " profile events to " << path;
+	if (dropped_count > 0) {
+		std::cout << " (" << dropped_count << " dropped)";
+	}
+	std::cout << std::endl;
+	return ok;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include "types.hpp"
+#include "timer.hpp"
+
+/**
+ * Scoped timing markers for finding where frame time goes.
+ *
+ * Put PROFILE_SCOPE("Name") at the start of a block to time the rest of the block.
+ * Every thread records into its own buffer so markers can be used from worker
+ * threads without locking. Recording only happens between profiler_start() and
+ * profiler_stop() and the result is written with profiler_write_trace() as
+ * Chrome trace JSON (open in chrome://tracing or ui.perfetto.dev).
+ * PROFILE_MUTE() drops the markers of everything called in the rest of the block,
+ * for code that runs far too often to record every call (ex. autopilot rollouts).
+ *
+ * The markers compile to nothing unless PROFILER is defined.
+ */
+
+// Max events stored per thread, events past this are dropped
+const int32 profiler_thread_event_capacity = 1 << 20;
+
+// Set while recording, read by every marker
+extern std::atomic<bool> profiler_recording;
+
+// Start recording markers on every thread, clears anything recorded before
+void profiler_start();
+
+// Stop recording markers
+void profiler_stop();
+
+bool profiler_is_recording();
+
+/**
+ * Write the recorded markers as Chrome trace JSON.
+ * Must be called after profiler_stop() once threads are done recording.
+ * @returns False if the file couldn't be written
+ */
+bool profiler_write_trace(const char* path);
+
+// Store one marker for the calling thread (use PROFILE_SCOPE instead)
+void profiler_record(const char* name, uint64 start_ns, uint64 end_ns);
+
+// Stop and restart recording markers on the calling thread (use PROFILE_MUTE instead)
+void profiler_push_mute();
+void profiler_pop_mute();
+
+/**
+ * Times its own lifetime, name must be a string that outlives the capture (ex. a literal)
+ */
+struct ProfileScope {
+	const char* name;
+	uint64      start_ns; // 0 if not recording when the scope started
+
+	ProfileScope(const char* name) : name(name), start_ns(0) {
+		if (profiler_recording.load(std::memory_order_relaxed)) {
+			start_ns = timer_nanoseconds();
+		}
+	}
+
+	~ProfileScope() {
+		if (start_ns != 0) {
+			profiler_record(name, start_ns, timer_nanoseconds());
+		}
+	}
+};
+
+struct ProfileMute {
+	ProfileMute() { profiler_push_mute(); }
+	~ProfileMute() { profiler_pop_mute(); }
+};
+
+#ifdef PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_MUTE() ProfileMute PROFILE_CONCAT(profile_mute_, __LINE__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_MUTE()
+#endif
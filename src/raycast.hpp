@@ -1,3 +1,5 @@
+#pragma once
+
 #include "types.hpp"
 #include "vector.hpp"
 
@@ -12,7 +14,7 @@
  * @param normal Normal of the intersection
  * @returns True if there was a intersection
  */
-bool raycast_circle(Vec2 ray_pos, Vec2 ray_dir, Vec2 circle_pos, float32 circle_radius, 
+inline bool raycast_circle(Vec2 ray_pos, Vec2 ray_dir, Vec2 circle_pos, float32 circle_radius, 
 		float32* distance, Vec2* point, Vec2* normal)
 {
 	// Rename some variables for convenience
@@ -58,7 +60,7 @@ bool raycast_circle(Vec2 ray_pos, Vec2 ray_dir, Vec2 circle_pos, float32 circle_
  * @param normal Normal of the intersection
  * @returns True if there was a intersection
  */
-bool raycast_horizontal_line(Vec2 ray_pos, Vec2 ray_dir, float32 y,
+inline bool raycast_horizontal_line(Vec2 ray_pos, Vec2 ray_dir, float32 y,
 		float32* distance, Vec2* point, Vec2* normal)
 {
 	Vec2 delta; // Vector between ray_pos and intersection point
@@ -90,7 +92,7 @@ bool raycast_horizontal_line(Vec2 ray_pos, Vec2 ray_dir, float32 y,
  * @param normal Normal of the intersection
  * @returns True if there was a intersection
  */
-bool raycast_horizontal_line_segment(Vec2 ray_pos, Vec2 ray_dir, float32 y, float32 x_min, float32 x_max,
+inline bool raycast_horizontal_line_segment(Vec2 ray_pos, Vec2 ray_dir, float32 y, float32 x_min, float32 x_max,
 		float32* distance, Vec2* point, Vec2* normal)
 {
 	if (!raycast_horizontal_line(ray_pos, ray_dir, y, distance, point, normal)) {
@@ -114,7 +116,7 @@ bool raycast_horizontal_line_segment(Vec2 ray_pos, Vec2 ray_dir, float32 y, floa
  * @param normal Normal of the intersection
  * @returns True if there was a intersection
  */
-bool raycast_vertical_line(Vec2 ray_pos, Vec2 ray_dir, float32 x,
+inline bool raycast_vertical_line(Vec2 ray_pos, Vec2 ray_dir, float32 x,
 		float32* distance, Vec2* point, Vec2* normal)
 {
 	Vec2 delta; // Vector between ray_pos and intersection point
@@ -146,7 +148,7 @@ bool raycast_vertical_line(Vec2 ray_pos, Vec2 ray_dir, float32 x,
  * @param normal Normal of the intersection
  * @returns True if there was a intersection
  */
-bool raycast_vertical_line_segment(Vec2 ray_pos, Vec2 ray_dir, float32 x, float32 y_min, float32 y_max,
+inline bool raycast_vertical_line_segment(Vec2 ray_pos, Vec2 ray_dir, float32 x, float32 y_min, float32 y_max,
 		float32* distance, Vec2* point, Vec2* normal)
 {
 	if (!raycast_vertical_line(ray_pos, ray_dir, x, distance, point, normal)) {
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include "types.hpp"
+#include "game.hpp"
+#include "stats.hpp"
+#include "timer.hpp"
+
+/**
+ * Rolling capture of the last few seconds of play that can be written to disk
+ * as a replay when something goes wrong (ex. a frame time spike).
+ *
+ * The recorder keeps the input of every frame plus a snapshot of the game every
+ * replay_keyframe_interval frames. A replay is the newest snapshot at least
+ * replay_window_frames old, the inputs from there on and a snapshot of the
+ * game at the end, so playing it back can check it reproduces the same game.
+ *
+ * File layout: ReplayHeader, start snapshot, frame_count ReplayFrames, end snapshot.
+ * Snapshots are raw simulation state, so replays only load in the build that recorded them
+ * and only of the default level (the snapshot size depends on the number of tiles).
+ */
+
+const uint32 replay_magic             = 0x4C505242; // "BRPL"
+const uint32 replay_version           = 1;
+const int32  replay_window_frames     = 300; // Min frames before the spike in a replay (5 seconds at 60 fps)
+const int32  replay_keyframe_interval = 60;
+const int32  replay_frame_capacity    = replay_window_frames + replay_keyframe_interval;
+const int32  replay_keyframe_count    = replay_frame_capacity / replay_keyframe_interval + 1;
+
+struct ReplayFrame {
+	float64 delta_time;
+	float64 frame_time;
+	uint8   left_key_pressed;
+	uint8   right_key_pressed;
+	uint8   start_key_pressed;
+	uint8   start_key_pressed_prev;
+	uint8   rewind_key_pressed; // Rewinding can't be played back since the rewind history isn't saved
+};
+
+struct ReplayHeader {
+	uint32 magic;
+	uint32 version;
+	int32  snapshot_size;
+	int32  frame_count;
+};
+
+struct ReplayRecorder {
+	int32 snapshot_size;
+
+	ReplayFrame frames[replay_frame_capacity]; // Ring of the latest frames
+	uint8*      keyframes;                     // Ring of replay_keyframe_count snapshots
+	int64       frame_count;                   // Frames recorded in total
+	int64       last_dump_frame;               // Used to skip dumps that would overlap the previous one
+};
+
+/**
+ * Create a recorder for the level the game is on (remember to call free_replay_recorder() after)
+ */
+ReplayRecorder* create_replay_recorder(const Game::Data* data) {
+	ReplayRecorder* recorder = new ReplayRecorder;
+	recorder->snapshot_size = Game::snapshot_size(data);
+	recorder->keyframes = new uint8[recorder->snapshot_size * replay_keyframe_count];
+	recorder->frame_count = 0;
+	recorder->last_dump_frame = -replay_window_frames;
+	return recorder;
+}
+
+void free_replay_recorder(ReplayRecorder* recorder) {
+	delete[] recorder->keyframes;
+	delete recorder;
+}
+
+/**
+ * Record the input of a frame, call right before Game::update()
+ */
+void replay_record_frame(ReplayRecorder* recorder, const Game::Data* data, const Game::Input* input) {
+	int64 frame = recorder->frame_count;
+	if (frame % replay_keyframe_interval == 0) {
+		int32 keyframe = (int32)((frame / replay_keyframe_interval) % replay_keyframe_count);
+		Game::save_snapshot(data, recorder->keyframes + keyframe * recorder->snapshot_size);
+	}
+
+	ReplayFrame* replay_frame = &recorder->frames[frame % replay_frame_capacity];
+	replay_frame->delta_time = input->delta_time;
+	replay_frame->frame_time = input->frame_time;
+	replay_frame->left_key_pressed = input->left_key_pressed;
+	replay_frame->right_key_pressed = input->right_key_pressed;
+	replay_frame->start_key_pressed = input->start_key_pressed;
+	replay_frame->start_key_pressed_prev = input->start_key_pressed_prev;
+	replay_frame->rewind_key_pressed = input->rewind_key_pressed;
+
+	recorder->frame_count++;
+}
+
+/**
+ * True if a dump now wouldn't overlap the frames of the previous dump
+ */
+bool replay_can_dump(const ReplayRecorder* recorder) {
+	return recorder->frame_count - recorder->last_dump_frame >= replay_window_frames;
+}
+
+/**
+ * Write the recorded window to a replay file, call right after Game::update()
+ * @returns False if the file couldn't be written
+ */
+bool replay_dump(ReplayRecorder* recorder, const Game::Data* data, const char* path) {
+	int64 end_frame = recorder->frame_count;
+	int64 start_frame = ((end_frame - replay_window_frames) / replay_keyframe_interval) * replay_keyframe_interval;
+	if (start_frame < 0) {
+		start_frame = 0;
+	}
+	int32 keyframe = (int32)((start_frame / replay_keyframe_interval) % replay_keyframe_count);
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		std::cout << "Failed to open replay file: " << path << std::endl;
+		return false;
+	}
+
+	ReplayHeader header;
+	header.magic = replay_magic;
+	header.version = replay_version;
+	header.snapshot_size = recorder->snapshot_size;
+	header.frame_count = (int32)(end_frame - start_frame);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(recorder->keyframes + keyframe * recorder->snapshot_size, recorder->snapshot_size, 1, file);
+
+	for (int64 frame = start_frame; frame < end_frame; frame++) {
+		fwrite(&recorder->frames[frame % replay_frame_capacity], sizeof(ReplayFrame), 1, file);
+	}
+
+	uint8* end_snapshot = new uint8[recorder->snapshot_size];
+	Game::save_snapshot(data, end_snapshot);
+	fwrite(end_snapshot, recorder->snapshot_size, 1, file);
+	delete[] end_snapshot;
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+
+	recorder->last_dump_frame = end_frame;
+	std::cout << "Wrote replay of " << header.frame_count << " frames to " << path << std::endl;
+	return ok;
+}
+
+/**
+ * Play a replay headless, reporting update times and whether it reproduced the recorded game
+ * @returns Process exit code
+ */
+int replay_run(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		std::cout << "Failed to open replay file: " << path << std::endl;
+		return 1;
+	}
+
+	ReplayHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != replay_magic || header.version != replay_version) {
+		std::cout << "Not a replay file: " << path << std::endl;
+		fclose(file);
+		return 1;
+	}
+
+	Game::Data* game_data = Game::init_headless(Vec2Int(Game::default_grid_size_x, Game::default_grid_size_y));
+	if (header.snapshot_size != Game::snapshot_size(game_data) || header.frame_count < 0) {
+		std::cout << "Replay was recorded by a different build or on a different level: " << path << std::endl;
+		Game::free_headless(game_data);
+		fclose(file);
+		return 1;
+	}
+
+	uint8* start_snapshot = new uint8[header.snapshot_size];
+	uint8* end_snapshot = new uint8[header.snapshot_size];
+	ReplayFrame* frames = new ReplayFrame[header.frame_count];
+	bool read_ok = fread(start_snapshot, header.snapshot_size, 1, file) == 1
+			&& fread(frames, sizeof(ReplayFrame), header.frame_count, file) == (size_t)header.frame_count
+			&& fread(end_snapshot, header.snapshot_size, 1, file) == 1;
+	fclose(file);
+
+	if (!read_ok) {
+		std::cout << "Replay file is truncated: " << path << std::endl;
+		delete[] start_snapshot;
+		delete[] end_snapshot;
+		delete[] frames;
+		Game::free_headless(game_data);
+		return 1;
+	}
+
+	Game::load_snapshot(game_data, start_snapshot);
+
+	Histogram* update_times = new Histogram;
+	histogram_reset(update_times);
+
+	Game::Input input = {};
+	for (int32 i = 0; i < header.frame_count; i++) {
+		ReplayFrame* frame = &frames[i];
+		input.delta_time = frame->delta_time;
+		input.frame_time = frame->frame_time;
+		input.left_key_pressed = frame->left_key_pressed;
+		input.right_key_pressed = frame->right_key_pressed;
+		input.start_key_pressed = frame->start_key_pressed;
+		input.start_key_pressed_prev = frame->start_key_pressed_prev;
+		input.rewind_key_pressed = frame->rewind_key_pressed;
+
+		uint64 update_start = timer_nanoseconds();
+		Game::update(&input, game_data);
+		histogram_record(update_times, timer_nanoseconds() - update_start);
+
+		if (Game::collision_limit_hit(game_data)) {
+			std::cout << "Frame " << i << " hit the max collision iterations" << std::endl;
+		}
+	}
+
+	std::cout << "Replayed " << header.frame_count << " frames from " << path << std::endl;
+	histogram_print(update_times, "Update");
+
+	Game::save_snapshot(game_data, start_snapshot);
+	bool matches = memcmp(start_snapshot, end_snapshot, header.snapshot_size) == 0;
+	if (matches) {
+		std::cout << "Replay reproduced the recorded game." << std::endl;
+	} else {
+		std::cout << "Replay diverged from the recorded game." << std::endl;
+	}
+
+	delete update_times;
+	delete[] start_snapshot;
+	delete[] end_snapshot;
+	delete[] frames;
+	return matches ? 0 : 1;
+}
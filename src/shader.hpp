@@ -1,10 +1,17 @@
 #pragma once
 
 #include <stdio.h>
+#include <string.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "types.hpp"
 
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile (not in the glad 3.3 loader)
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+
+typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
 void print_shader_logs(uint32 shader) {
 	int32 log_size = 0;
 	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_size);
@@ -16,55 +23,140 @@ void print_shader_logs(uint32 shader) {
 	delete[] log;
 }
 
+void print_program_logs(uint32 program) {
+	int32 log_size = 0;
+	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_size);
+
+	char* log = new char[log_size + 1];
+	log[0] = '\0';
+	glGetProgramInfoLog(program, log_size + 1, NULL, log);
+
+	std::cout << "Shader Link Error: " << log << std::endl;
+	delete[] log;
+}
+
+bool has_gl_extension(const char* name) {
+	int32 extension_count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+	for (int32 i = 0; i < extension_count; i++) {
+		if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Let the driver compile and link shaders on its own threads if it supports
+ * KHR_parallel_shader_compile, so programs started with begin_shader_program()
+ * build concurrently. Without it the driver compiles them one by one.
+ * @returns True if parallel compiling was enabled
+ */
+bool enable_parallel_shader_compile(void* (*get_proc_address)(const char* name)) {
+	if (get_proc_address == NULL) {
+		return false;
+	}
+
+	MaxShaderCompilerThreadsProc max_shader_compiler_threads = NULL;
+	if (has_gl_extension("GL_KHR_parallel_shader_compile")) {
+		max_shader_compiler_threads = (MaxShaderCompilerThreadsProc)get_proc_address("glMaxShaderCompilerThreadsKHR");
+	} else if (has_gl_extension("GL_ARB_parallel_shader_compile")) {
+		max_shader_compiler_threads = (MaxShaderCompilerThreadsProc)get_proc_address("glMaxShaderCompilerThreadsARB");
+	}
+
+	if (max_shader_compiler_threads == NULL) {
+		return false;
+	}
+
+	max_shader_compiler_threads(0xFFFFFFFF); // As many threads as the driver wants
+	return true;
+}
+
 /**
- * Create a shader from the text.
- * Note: Need to delete shader after linking with glDeleteShader()
+ * Program whose shaders were handed to the driver but not checked yet
  */
-uint32 create_shader(char* shader_code, GLenum shader_type) {
+struct PendingShaderProgram {
+	uint32 program;
+	uint32 vert_shader;
+	uint32 frag_shader;
+};
+
+/**
+ * Start compiling a shader from the text, which doesn't need to be null terminated
+ */
+uint32 start_shader(const char* shader_code, int32 shader_code_length, GLenum shader_type) {
 	uint32 shader = glCreateShader(shader_type);
-	glShaderSource(shader, 1, &shader_code, NULL);
+	glShaderSource(shader, 1, &shader_code, &shader_code_length);
 	glCompileShader(shader);
+	return shader;
+}
 
-	int32 compile_success = 0;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_success);
-	if (compile_success) {
-		return shader;
-	}
-	
-	print_shader_logs(shader);
-	glDeleteShader(shader);
-	return 0;
+/**
+ * Start compiling a vertex and fragment shader and linking them into an existing program
+ * (so program parameters can be set first). Nothing waits on the driver until
+ * finish_shader_program(), so other work can happen while the program builds.
+ */
+void begin_shader_program(PendingShaderProgram* pending, uint32 program, const char* vert_shader_code, int32 vert_shader_code_length,
+		const char* frag_shader_code, int32 frag_shader_code_length) {
+	pending->program = program;
+	pending->vert_shader = start_shader(vert_shader_code, vert_shader_code_length, GL_VERTEX_SHADER);
+	pending->frag_shader = start_shader(frag_shader_code, frag_shader_code_length, GL_FRAGMENT_SHADER);
+
+	glAttachShader(program, pending->vert_shader);
+	glAttachShader(program, pending->frag_shader);
+	glLinkProgram(program);
 }
 
 /**
- * Create a shader program from the text of a vertex and fragment shader.
+ * Check if the driver finished a program started with begin_shader_program() without
+ * waiting for it, only valid after enable_parallel_shader_compile() returned true
  */
-uint32 create_shader_program(char* vert_shader_code, char* frag_shader_code) {
-	uint32 vert_shader = create_shader(vert_shader_code, GL_VERTEX_SHADER);
-	if (vert_shader == 0) {
-		return 0;
-	}
+bool shader_program_ready(const PendingShaderProgram* pending) {
+	int32 completed = 0;
+	glGetProgramiv(pending->program, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed;
+}
+
+/**
+ * Wait for a program started with begin_shader_program() and print the logs if it failed
+ * @returns False if compiling or linking failed
+ */
+bool finish_shader_program(PendingShaderProgram* pending) {
+	int32 link_success = 0;
+	glGetProgramiv(pending->program, GL_LINK_STATUS, &link_success);
 
-	uint32 frag_shader = create_shader(frag_shader_code, GL_FRAGMENT_SHADER);
-	if (frag_shader == 0) {
-		glDeleteShader(vert_shader);
-		return 0;
+	if (!link_success) {
+		int32 vert_success = 0;
+		int32 frag_success = 0;
+		glGetShaderiv(pending->vert_shader, GL_COMPILE_STATUS, &vert_success);
+		glGetShaderiv(pending->frag_shader, GL_COMPILE_STATUS, &frag_success);
+		if (!vert_success) {
+			print_shader_logs(pending->vert_shader);
+		}
+		if (!frag_success) {
+			print_shader_logs(pending->frag_shader);
+		}
+		if (vert_success && frag_success) {
+			print_program_logs(pending->program);
+		}
 	}
 
-	uint32 program = glCreateProgram();
-	glAttachShader(program, vert_shader);
-	glAttachShader(program, frag_shader);
-	glLinkProgram(program);
-	glDeleteShader(vert_shader);
-	glDeleteShader(frag_shader);
+	glDeleteShader(pending->vert_shader);
+	glDeleteShader(pending->frag_shader);
+	return link_success;
+}
 
-	int32 link_success;
-	glGetProgramiv(program, GL_LINK_STATUS, &link_success);
-	if (link_success) {
-		return program;
+/**
+ * Create a shader program from the text of a vertex and fragment shader, waiting until it's built.
+ */
+uint32 create_shader_program(const char* vert_shader_code, int32 vert_shader_code_length,
+		const char* frag_shader_code, int32 frag_shader_code_length) {
+	PendingShaderProgram pending;
+	begin_shader_program(&pending, glCreateProgram(), vert_shader_code, vert_shader_code_length, frag_shader_code, frag_shader_code_length);
+	if (finish_shader_program(&pending)) {
+		return pending.program;
 	}
 
-	print_shader_logs(program);
-	glDeleteProgram(program);
+	glDeleteProgram(pending.program);
 	return 0;
 }
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <glad/glad.h>
+#include "types.hpp"
+#include "arena.hpp"
+#include "shader.hpp"
+
+#ifdef WINDOWS
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+/**
+ * Cache of linked shader programs so later launches skip compiling and linking.
+ *
+ * Programs are saved with glGetProgramBinary (OpenGL 4.1 or ARB_get_program_binary,
+ * loaded by hand since glad is generated for 3.3) to one file per program, named
+ * by a hash of the shader sources and the driver vendor, renderer and version.
+ * Updating the driver or a shader changes the name so stale binaries are never
+ * loaded, and a binary the driver rejects anyway is recompiled and overwritten.
+ */
+
+const uint32 shader_cache_magic   = 0x48435342; // "BSCH"
+const uint32 shader_cache_version = 1;
+
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei buffer_size, GLsizei* length, GLenum* binary_format, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum name, GLint value);
+
+struct ShaderCacheHeader {
+	uint32 magic;
+	uint32 version;
+	uint64 key;
+	uint32 binary_format;
+	int32  binary_size;
+};
+
+struct ShaderCache {
+	bool        enabled;
+	const char* directory;
+	uint64      driver_hash;
+	Arena*      scratch; // Holds binaries while they are read or written
+
+	GetProgramBinaryProc  get_program_binary;
+	ProgramBinaryProc     program_binary;
+	ProgramParameteriProc program_parameteri;
+
+	int32 loaded_count;   // Programs loaded from the cache
+	int32 compiled_count; // Programs compiled because they weren't cached or the driver rejected them
+};
+
+/**
+ * FNV-1a, continuing from hash
+ */
+uint64 shader_cache_hash(uint64 hash, const void* data, uint64 size) {
+	const uint8* bytes = (const uint8*)data;
+	for (uint64 i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64 shader_cache_hash_string(uint64 hash, const char* string) {
+	// Include the terminator so "ab" + "c" and "a" + "bc" differ
+	return shader_cache_hash(hash, string, strlen(string) + 1);
+}
+
+/**
+ * Set up the cache, it stays disabled if the driver can't save program binaries
+ * @param directory Where binaries are saved, NULL to disable the cache
+ * @param get_proc_address Loads the program binary functions
+ * @param scratch Arena for reading and writing binaries
+ */
+void init_shader_cache(ShaderCache* cache, const char* directory, void* (*get_proc_address)(const char* name), Arena* scratch) {
+	memset(cache, 0, sizeof(ShaderCache));
+	cache->directory = directory;
+	cache->scratch = scratch;
+	if (directory == NULL || get_proc_address == NULL) {
+		return;
+	}
+
+	bool supported = (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1))
+			|| has_gl_extension("GL_ARB_get_program_binary");
+	if (!supported) {
+		return;
+	}
+
+	// Drivers can support the functions without any binary formats (ex. macOS)
+	int32 format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	if (format_count <= 0) {
+		return;
+	}
+
+	cache->get_program_binary = (GetProgramBinaryProc)get_proc_address("glGetProgramBinary");
+	cache->program_binary = (ProgramBinaryProc)get_proc_address("glProgramBinary");
+	cache->program_parameteri = (ProgramParameteriProc)get_proc_address("glProgramParameteri");
+	if (cache->get_program_binary == NULL || cache->program_binary == NULL || cache->program_parameteri == NULL) {
+		return;
+	}
+
+	uint64 hash = 14695981039346656037ull;
+	hash = shader_cache_hash_string(hash, (const char*)glGetString(GL_VENDOR));
+	hash = shader_cache_hash_string(hash, (const char*)glGetString(GL_RENDERER));
+	hash = shader_cache_hash_string(hash, (const char*)glGetString(GL_VERSION));
+	cache->driver_hash = hash;
+	cache->enabled = true;
+}
+
+/**
+ * Path of the cache file for a key
+ */
+void shader_cache_path(const ShaderCache* cache, uint64 key, char* path, int32 path_size) {
+	snprintf(path, path_size, "%s/%016llx.bin", cache->directory, (unsigned long long)key);
+}
+
+/**
+ * Try to create a program from a cached binary
+ * @returns 0 if there is no usable binary
+ */
+uint32 load_cached_program(ShaderCache* cache, uint64 key) {
+	char path[512];
+	shader_cache_path(cache, key, path, sizeof(path));
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return 0;
+	}
+
+	ShaderCacheHeader header;
+	void* binary = NULL;
+	if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == shader_cache_magic
+			&& header.version == shader_cache_version && header.key == key && header.binary_size > 0) {
+		binary = arena_push(cache->scratch, header.binary_size);
+		if (binary != NULL && fread(binary, header.binary_size, 1, file) != 1) {
+			binary = NULL;
+		}
+	}
+	fclose(file);
+
+	if (binary == NULL) {
+		std::cout << "Ignoring invalid shader cache file: " << path << std::endl;
+		return 0;
+	}
+
+	uint32 program = glCreateProgram();
+	cache->program_binary(program, header.binary_format, binary, header.binary_size);
+
+	int32 link_success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_success);
+	if (!link_success) {
+		std::cout << "Driver rejected cached shader program, recompiling: " << path << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+/**
+ * Save the binary of a linked program, failures only mean the next launch compiles it again
+ */
+void save_cached_program(ShaderCache* cache, uint64 key, uint32 program) {
+	int32 binary_size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+	if (binary_size <= 0) {
+		return;
+	}
+
+	void* binary = arena_push(cache->scratch, binary_size);
+	if (binary == NULL) {
+		return;
+	}
+
+	ShaderCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = shader_cache_magic;
+	header.version = shader_cache_version;
+	header.key = key;
+	GLenum binary_format = 0;
+	cache->get_program_binary(program, binary_size, &binary_size, &binary_format, binary);
+	header.binary_format = binary_format;
+	header.binary_size = binary_size;
+
+	#ifdef WINDOWS
+	_mkdir(cache->directory);
+	#else
+	mkdir(cache->directory, 0755);
+	#endif
+
+	char path[512];
+	shader_cache_path(cache, key, path, sizeof(path));
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		std::cout << "Failed to write shader cache file: " << path << std::endl;
+		return;
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(binary, binary_size, 1, file);
+	fclose(file);
+}
+
+/**
+ * Program that is either loaded from the cache or still building
+ */
+struct PendingCachedProgram {
+	PendingShaderProgram pending;
+	uint64               key;
+	bool                 loaded; // Loaded from the cache, there is nothing to wait for
+};
+
+/**
+ * Same as begin_shader_program() but loads the program from the cache when possible
+ */
+void begin_cached_shader_program(ShaderCache* cache, PendingCachedProgram* cached, const char* vert_shader_code, 
+		int32 vert_shader_code_length, const char* frag_shader_code, int32 frag_shader_code_length) {
+	cached->loaded = false;
+	cached->key = shader_cache_hash(cache->driver_hash, &vert_shader_code_length, sizeof(vert_shader_code_length));
+	cached->key = shader_cache_hash(cached->key, vert_shader_code, vert_shader_code_length);
+	cached->key = shader_cache_hash(cached->key, frag_shader_code, frag_shader_code_length);
+
+	if (cache->enabled) {
+		cached->pending.program = load_cached_program(cache, cached->key);
+		if (cached->pending.program != 0) {
+			cached->loaded = true;
+			cache->loaded_count++;
+			return;
+		}
+	}
+
+	cache->compiled_count++;
+	uint32 program = glCreateProgram();
+	if (cache->enabled) {
+		cache->program_parameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	begin_shader_program(&cached->pending, program, vert_shader_code, vert_shader_code_length, frag_shader_code, frag_shader_code_length);
+}
+
+/**
+ * Same as shader_program_ready(), programs loaded from the cache are always ready
+ */
+bool cached_shader_program_ready(const PendingCachedProgram* cached) {
+	return cached->loaded || shader_program_ready(&cached->pending);
+}
+
+/**
+ * Same as finish_shader_program(), saving newly built programs to the cache
+ * @returns The program, 0 if compiling or linking failed
+ */
+uint32 finish_cached_shader_program(ShaderCache* cache, PendingCachedProgram* cached) {
+	if (cached->loaded) {
+		return cached->pending.program;
+	}
+
+	if (!finish_shader_program(&cached->pending)) {
+		glDeleteProgram(cached->pending.program);
+		return 0;
+	}
+
+	if (cache->enabled) {
+		save_cached_program(cache, cached->key, cached->pending.program);
+	}
+	return cached->pending.program;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include "types.hpp"
+
+/**
+ * Lock free ring buffer for passing items from exactly one producer thread
+ * to exactly one consumer thread.
+ *
+ * The producer only writes tail and the consumer only writes head, each on
+ * its own cache line so the two threads don't slow each other down.
+ * Capacity must be a power of two.
+ */
+template<typename T, int32 Capacity>
+struct SpscQueue {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	alignas(64) std::atomic<uint32> head; // Next item to pop, written by the consumer
+	alignas(64) std::atomic<uint32> tail; // Next slot to push to, written by the producer
+	alignas(64) T items[Capacity];
+};
+
+template<typename T, int32 Capacity>
+void spsc_reset(SpscQueue<T, Capacity>* queue) {
+	queue->head.store(0, std::memory_order_relaxed);
+	queue->tail.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Add an item, producer thread only
+ * @returns False if the queue is full
+ */
+template<typename T, int32 Capacity>
+bool spsc_push(SpscQueue<T, Capacity>* queue, const T& item) {
+	uint32 tail = queue->tail.load(std::memory_order_relaxed);
+	if (tail - queue->head.load(std::memory_order_acquire) == (uint32)Capacity) {
+		return false;
+	}
+
+	queue->items[tail & (Capacity - 1)] = item;
+	queue->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+/**
+ * Take the oldest item, consumer thread only
+ * @returns False if the queue is empty
+ */
+template<typename T, int32 Capacity>
+bool spsc_pop(SpscQueue<T, Capacity>* queue, T* item) {
+	uint32 head = queue->head.load(std::memory_order_relaxed);
+	if (head == queue->tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	*item = queue->items[head & (Capacity - 1)];
+	queue->head.store(head + 1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <iostream>
+#include <stdio.h>
+#include "types.hpp"
+#include "timer.hpp"
+
+#ifdef WINDOWS
+#include <Windows.h>
+#elif MACOS
+#include <sys/sysctl.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Timeline of startup from process start to the first frame on screen.
+ *
+ * Call startup_trace_begin() first thing in main(), then startup_trace_mark()
+ * as each phase finishes (the game reports its init() phases the same way
+ * through Game::Input::trace_startup). startup_trace_report() prints how long
+ * every phase took, which adds up to the time to first frame.
+ */
+
+const int32 startup_trace_capacity = 32;
+
+struct StartupTrace {
+	uint64      start;               // timer_nanoseconds() when main() started
+	float64     before_main_seconds; // Process creation to main() (loading, static initializers), negative if unknown
+	int32       phase_count;
+	const char* phase_names[startup_trace_capacity];
+	uint64      phase_ends[startup_trace_capacity];
+};
+
+StartupTrace startup_trace;
+
+/**
+ * Seconds since the OS created the process, negative if the platform doesn't tell us
+ */
+float64 process_age_seconds() {
+	#ifdef WINDOWS
+	FILETIME creation_time, exit_time, kernel_time, user_time, now;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+		return -1.0;
+	}
+	GetSystemTimeAsFileTime(&now);
+	uint64 created = ((uint64)creation_time.dwHighDateTime << 32) | creation_time.dwLowDateTime;
+	uint64 current = ((uint64)now.dwHighDateTime << 32) | now.dwLowDateTime;
+	return (float64)(current - created) * 100e-9; // FILETIME counts 100ns intervals
+
+	#elif MACOS
+	int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+	struct kinfo_proc info;
+	size_t info_size = sizeof(info);
+	if (sysctl(mib, 4, &info, &info_size, NULL, 0) != 0) {
+		return -1.0;
+	}
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	struct timeval started = info.kp_proc.p_starttime;
+	return (float64)(now.tv_sec - started.tv_sec) + (float64)(now.tv_usec - started.tv_usec) * 1e-6;
+
+	#else
+	return -1.0;
+	#endif
+}
+
+void startup_trace_begin() {
+	startup_trace.start = timer_nanoseconds();
+	startup_trace.before_main_seconds = process_age_seconds();
+	startup_trace.phase_count = 0;
+}
+
+/**
+ * Record that a phase just finished, it started when the previous phase finished
+ * @param phase Name, must outlive the trace (ex. a string literal)
+ */
+void startup_trace_mark(const char* phase) {
+	if (startup_trace.phase_count >= startup_trace_capacity) {
+		return;
+	}
+	startup_trace.phase_names[startup_trace.phase_count] = phase;
+	startup_trace.phase_ends[startup_trace.phase_count] = timer_nanoseconds();
+	startup_trace.phase_count++;
+}
+
+/**
+ * Print the duration of every phase and the time to first frame
+ */
+void startup_trace_report() {
+	std::cout << "Startup:" << std::endl;
+
+	float64 total_ms = 0.0;
+	char line[256];
+	if (startup_trace.before_main_seconds >= 0.0) {
+		total_ms = startup_trace.before_main_seconds * 1000.0;
+		snprintf(line, sizeof(line), "  %-28s %9.2f ms", "Process start to main", total_ms);
+		std::cout << line << std::endl;
+	}
+
+	uint64 phase_start = startup_trace.start;
+	for (int32 i = 0; i < startup_trace.phase_count; i++) {
+		float64 phase_ms = (float64)(startup_trace.phase_ends[i] - phase_start) / 1e6;
+		snprintf(line, sizeof(line), "  %-28s %9.2f ms", startup_trace.phase_names[i], phase_ms);
+		std::cout << line << std::endl;
+		total_ms += phase_ms;
+		phase_start = startup_trace.phase_ends[i];
+	}
+
+	snprintf(line, sizeof(line), "  %-28s %9.2f ms%s", "Time to first frame", total_ms,
+			startup_trace.before_main_seconds >= 0.0 ? "" : " (from main)");
+	std::cout << line << std::endl;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <iostream>
+#include <stdio.h>
+#include "types.hpp"
+
+/**
+ * Log-linear (HDR style) histogram for timings.
+ *
+ * Values below 2^histogram_precision_bits get their own bucket, larger values
+ * share a bucket with everything that has the same top histogram_precision_bits
+ * bits, so every recorded value is kept to within about 3% no matter how large
+ * it is. Recording is a few instructions and the histogram never allocates,
+ * so it can stay on for a whole session to catch rare spikes.
+ */
+
+const int32 histogram_precision_bits = 6;
+const int32 histogram_half_range     = 1 << (histogram_precision_bits - 1);
+const int32 histogram_bucket_count   = (64 - histogram_precision_bits + 2) * histogram_half_range;
+
+struct Histogram {
+	uint64 counts[histogram_bucket_count];
+	uint64 total_count;
+	uint64 sum;
+	uint64 min;
+	uint64 max;
+};
+
+void histogram_reset(Histogram* histogram) {
+	for (int i = 0; i < histogram_bucket_count; i++) {
+		histogram->counts[i] = 0;
+	}
+	histogram->total_count = 0;
+	histogram->sum = 0;
+	histogram->min = UINT64_MAX;
+	histogram->max = 0;
+}
+
+int32 histogram_bucket_index(uint64 value) {
+	if (value < (uint64)histogram_half_range * 2) {
+		return (int32)value;
+	}
+
+	int32 top_bit = 63 - __builtin_clzll(value);
+	int32 shift = top_bit - (histogram_precision_bits - 1);
+	return shift * histogram_half_range + (int32)(value >> shift);
+}
+
+/**
+ * Largest value that falls in the bucket
+ */
+uint64 histogram_bucket_value(int32 index) {
+	if (index < histogram_half_range * 2) {
+		return (uint64)index;
+	}
+
+	int32 shift = index / histogram_half_range - 1;
+	uint64 mantissa = (uint64)(index - shift * histogram_half_range);
+	return (mantissa << shift) + ((uint64)1 << shift) - 1;
+}
+
+void histogram_record(Histogram* histogram, uint64 value) {
+	histogram->counts[histogram_bucket_index(value)]++;
+	histogram->total_count++;
+	histogram->sum += value;
+	if (value < histogram->min) {
+		histogram->min = value;
+	}
+	if (value > histogram->max) {
+		histogram->max = value;
+	}
+}
+
+/**
+ * Value that percentile percent of the recorded values are less than or equal to
+ * @param percentile 0 to 100
+ */
+uint64 histogram_percentile(const Histogram* histogram, float64 percentile) {
+	if (histogram->total_count == 0) {
+		return 0;
+	}
+
+	uint64 target = (uint64)(percentile / 100.0 * histogram->total_count + 0.5);
+	if (target < 1) {
+		target = 1;
+	}
+
+	uint64 count = 0;
+	for (int i = 0; i < histogram_bucket_count; i++) {
+		count += histogram->counts[i];
+		if (count >= target) {
+			// The bucket's top can be past the largest value that was recorded
+			uint64 value = histogram_bucket_value(i);
+			return value < histogram->max ? value : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+/**
+ * Print the percentiles of a histogram of nanosecond timings in milliseconds
+ */
+void histogram_print(const Histogram* histogram, const char* name) {
+	if (histogram->total_count == 0) {
+		std::cout << name << ": no samples" << std::endl;
+		return;
+	}
+
+	char line[256];
+	snprintf(line, sizeof(line), "%-8s n=%-8llu mean %7.3f  p50 %7.3f  p90 %7.3f  p99 %7.3f  p99.9 %7.3f  max %7.3f ms",
+			name, (unsigned long long)histogram->total_count,
+			histogram->sum / (float64)histogram->total_count / 1e6,
+			histogram_percentile(histogram, 50.0) / 1e6,
+			histogram_percentile(histogram, 90.0) / 1e6,
+			histogram_percentile(histogram, 99.0) / 1e6,
+			histogram_percentile(histogram, 99.9) / 1e6,
+			histogram->max / 1e6);
+	std::cout << line << std::endl;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "types.hpp"
+
+/**
+ * Fixed set of worker threads that run the items of a job in parallel.
+ * The thread calling run_parallel() works on the job too.
+ */
+struct ThreadPool {
+	std::vector<std::thread> threads;
+
+	std::mutex              mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+	uint64                  generation;   // Incremented for every job
+	int32                   busy_threads; // Workers that haven't finished the current job
+	bool                    quit;
+
+	void (*job)(void* context, int32 index);
+	void*              context;
+	int32              item_count;
+	std::atomic<int32> next_item;
+};
+
+/**
+ * Run items of the current job until there are none left
+ */
+void run_thread_pool_items(ThreadPool* pool) {
+	while (true) {
+		int32 index = pool->next_item.fetch_add(1, std::memory_order_relaxed);
+		if (index >= pool->item_count) {
+			return;
+		}
+		pool->job(pool->context, index);
+	}
+}
+
+void thread_pool_worker(ThreadPool* pool) {
+	uint64 seen_generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(pool->mutex);
+			pool->work_ready.wait(lock, [&] { return pool->quit || pool->generation != seen_generation; });
+			if (pool->quit) {
+				return;
+			}
+			seen_generation = pool->generation;
+		}
+
+		run_thread_pool_items(pool);
+
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->busy_threads--;
+		if (pool->busy_threads == 0) {
+			pool->work_done.notify_one();
+		}
+	}
+}
+
+/**
+ * Create a pool (remember to call free_thread_pool() after)
+ * @param thread_count Total threads working on a job including the caller, 0 to use every hardware thread
+ */
+ThreadPool* create_thread_pool(int32 thread_count) {
+	if (thread_count <= 0) {
+		thread_count = (int32)std::thread::hardware_concurrency();
+	}
+
+	ThreadPool* pool = new ThreadPool;
+	pool->generation = 0;
+	pool->busy_threads = 0;
+	pool->quit = false;
+	pool->job = NULL;
+	pool->context = NULL;
+	pool->item_count = 0;
+	pool->next_item = 0;
+
+	for (int i = 1; i < thread_count; i++) {
+		pool->threads.push_back(std::thread(thread_pool_worker, pool));
+	}
+	return pool;
+}
+
+void free_thread_pool(ThreadPool* pool) {
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->quit = true;
+	}
+	pool->work_ready.notify_all();
+
+	for (size_t i = 0; i < pool->threads.size(); i++) {
+		pool->threads[i].join();
+	}
+	delete pool;
+}
+
+/**
+ * Call job(context, index) for every index from 0 to item_count - 1 and wait for them all to finish
+ */
+void run_parallel(ThreadPool* pool, int32 item_count, void (*job)(void* context, int32 index), void* context) {
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->job = job;
+		pool->context = context;
+		pool->item_count = item_count;
+		pool->next_item.store(0, std::memory_order_relaxed);
+		pool->busy_threads = (int32)pool->threads.size();
+		pool->generation++;
+	}
+	pool->work_ready.notify_all();
+
+	run_thread_pool_items(pool);
+
+	std::unique_lock<std::mutex> lock(pool->mutex);
+	pool->work_done.wait(lock, [&] { return pool->busy_threads == 0; });
+}
+
+int32 thread_pool_thread_count(const ThreadPool* pool) {
+	return (int32)pool->threads.size() + 1;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <chrono>
+#include "types.hpp"
+
+/**
+ * Monotonic time in nanoseconds since an unspecified point
+ * (clock_gettime(CLOCK_MONOTONIC) on Linux/macOS, QueryPerformanceCounter on Windows)
+ */
+inline uint64 timer_nanoseconds() {
+	return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
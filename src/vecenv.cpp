@@ -0,0 +1,73 @@
+#include "vecenv.hpp"
+#include "game.hpp"
+
+struct BreakoutVecEnv {
+	Game::Data*      games; // Only one of games or lanes is used
+	Game::LaneBatch* lanes;
+	int32            count;
+	Vec2Int          grid_size;
+	float64          delta_time;
+};
+
+BreakoutVecEnv* create_vec_env(int32 count, uint32 seed, float64 delta_time, Vec2Int grid_size, bool simd) {
+	if (count < 1 || grid_size.x < 1 || grid_size.y < 1 || (int64)grid_size.x * grid_size.y > Game::max_grid_tile_count) {
+		return NULL;
+	}
+
+	BreakoutVecEnv* handle = new BreakoutVecEnv;
+	handle->games = simd ? NULL : Game::init_batch(count, seed, grid_size);
+	handle->lanes = simd ? Game::init_lanes(count, seed, grid_size) : NULL;
+	handle->count = count;
+	handle->grid_size = grid_size;
+	handle->delta_time = delta_time > 0.0 ? delta_time : 1.0 / 60.0;
+	return handle;
+}
+
+BreakoutVecEnv* breakout_vec_create(int32 count, uint32 seed, float64 delta_time) {
+	return create_vec_env(count, seed, delta_time, Vec2Int(Game::default_grid_size_x, Game::default_grid_size_y), false);
+}
+
+BreakoutVecEnv* breakout_vec_create_simd(int32 count, uint32 seed, float64 delta_time) {
+	return create_vec_env(count, seed, delta_time, Vec2Int(Game::default_grid_size_x, Game::default_grid_size_y), true);
+}
+
+BreakoutVecEnv* breakout_vec_create_grid(int32 count, uint32 seed, float64 delta_time, int32 grid_x, int32 grid_y, bool simd) {
+	return create_vec_env(count, seed, delta_time, Vec2Int(grid_x, grid_y), simd);
+}
+
+void breakout_vec_destroy(BreakoutVecEnv* handle) {
+	if (handle == NULL) {
+		return;
+	}
+
+	if (handle->lanes != NULL) {
+		Game::free_lanes(handle->lanes);
+	} else {
+		Game::free_batch(handle->games);
+	}
+	delete handle;
+}
+
+int32 breakout_vec_count(const BreakoutVecEnv* handle) {
+	return handle->count;
+}
+
+int32 breakout_vec_observation_size(const BreakoutVecEnv* handle) {
+	return Game::batch_observation_size(handle->grid_size);
+}
+
+void breakout_vec_reset(BreakoutVecEnv* handle, float32* obs) {
+	if (handle->lanes != NULL) {
+		Game::reset_lanes(handle->lanes, obs);
+	} else {
+		Game::reset_batch(handle->games, handle->count, obs);
+	}
+}
+
+void breakout_vec_step(BreakoutVecEnv* handle, const uint8* actions, float32* obs, float32* rewards, uint8* dones) {
+	if (handle->lanes != NULL) {
+		Game::step_lanes(handle->lanes, handle->delta_time, actions, obs, rewards, dones);
+	} else {
+		Game::step_batch(handle->games, handle->count, handle->delta_time, actions, obs, rewards, dones);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "types.hpp"
+
+/**
+ * C interface for stepping many games at once from other languages
+ * (ex. Python through ctypes). All arrays are owned by the caller and
+ * hold one entry (or breakout_vec_observation_size() floats) per game.
+ */
+extern "C" {
+
+	struct BreakoutVecEnv;
+
+	// Create count games (remember to call breakout_vec_destroy() after)
+	BreakoutVecEnv* breakout_vec_create(int32 count, uint32 seed, float64 delta_time);
+
+	// Same as breakout_vec_create() but steps the games with the SIMD lane simulation, where
+	// each vector lane is a different game. Gives the same results as breakout_vec_create().
+	BreakoutVecEnv* breakout_vec_create_simd(int32 count, uint32 seed, float64 delta_time);
+
+	// Same as the functions above with a grid_x by grid_y grid of tiles instead of the default 12 by 3
+	// (the observation size grows with the grid), NULL if the grid size isn't valid
+	BreakoutVecEnv* breakout_vec_create_grid(int32 count, uint32 seed, float64 delta_time, int32 grid_x, int32 grid_y, bool simd);
+
+	void breakout_vec_destroy(BreakoutVecEnv* handle);
+
+	int32 breakout_vec_count(const BreakoutVecEnv* handle);
+
+	// Number of floats per game in the observations array
+	int32 breakout_vec_observation_size(const BreakoutVecEnv* handle);
+
+	// Start new games for every environment
+	void breakout_vec_reset(BreakoutVecEnv* handle, float32* obs);
+
+	// Step every game by one frame, finished games are reset automatically
+	// actions: 0 to stay still, 1 to move left, 2 to move right
+	void breakout_vec_step(BreakoutVecEnv* handle, const uint8* actions, float32* obs, float32* rewards, uint8* dones);
+}
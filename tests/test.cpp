@@ -1,6 +1,14 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <string.h>
+#include <vector>
 #include "../src/raycast.hpp"
+#include "../src/deltacompress.hpp"
+#include "../src/stats.hpp"
+#include "../src/arena.hpp"
+#include "../src/spscqueue.hpp"
+#include "../src/level.hpp"
 
 const std::string RED_TEXT = "\033[1;31m";
 const std::string GREEN_TEXT = "\033[32m";
@@ -73,6 +81,369 @@ std::string test_raycast_circle_miss(Vec2 ray_pos, Vec2 ray_dir, Vec2 circle_pos
 	return errors;
 }
 
+std::string test_delta_round_trip(int32 size, int32 change_stride) {
+	std::string errors = "";
+	uint8* prev = new uint8[size];
+	uint8* cur = new uint8[size];
+	uint8* encoded = new uint8[delta_max_encoded_size(size)];
+	for (int i = 0; i < size; i++) {
+		prev[i] = (uint8)(i * 7);
+		cur[i] = (i % change_stride == 0) ? (uint8)(i * 13 + 1) : prev[i];
+	}
+
+	int32 encoded_size = delta_encode(prev, cur, size, encoded);
+	verify(&errors, "encoded size in bounds", true, encoded_size <= delta_max_encoded_size(size));
+
+	// Applying the delta to either snapshot gives the other one
+	uint8* forward = new uint8[size];
+	uint8* backward = new uint8[size];
+	memcpy(forward, prev, size);
+	memcpy(backward, cur, size);
+	verify(&errors, "forward applied", true, delta_apply(forward, size, encoded, encoded_size));
+	verify(&errors, "backward applied", true, delta_apply(backward, size, encoded, encoded_size));
+	verify(&errors, "forward matches", true, memcmp(forward, cur, size) == 0);
+	verify(&errors, "backward matches", true, memcmp(backward, prev, size) == 0);
+
+	// A delta for a different size is rejected
+	verify(&errors, "size mismatch rejected", false, delta_apply(forward, size + 1, encoded, encoded_size));
+
+	// A delta joined from encoding only the parts that changed applies the same way,
+	// each part costs a run of unchanged bytes and its own encoding (at most 10 bytes for 1 byte)
+	uint8* joined = new uint8[size * 10 + 10];
+	uint8* out = joined;
+	int32 position = 0;
+	for (int i = 0; i < size; i += change_stride) {
+		out = delta_write_unchanged(out, i - position);
+		out += delta_encode(prev + i, cur + i, 1, out);
+		position = i + 1;
+	}
+	out = delta_write_unchanged(out, size - position);
+	memcpy(forward, prev, size);
+	verify(&errors, "joined applied", true, delta_apply(forward, size, joined, (int32)(out - joined)));
+	verify(&errors, "joined matches", true, memcmp(forward, cur, size) == 0);
+	delete[] joined;
+
+	delete[] prev;
+	delete[] cur;
+	delete[] encoded;
+	delete[] forward;
+	delete[] backward;
+	return errors;
+}
+
+/**
+ * Record 1 to value_count and check the percentiles are within the histogram precision
+ */
+std::string test_histogram_percentiles(uint64 value_count, uint64 scale) {
+	std::string errors = "";
+	Histogram* histogram = new Histogram;
+	histogram_reset(histogram);
+	for (uint64 i = 1; i <= value_count; i++) {
+		histogram_record(histogram, i * scale);
+	}
+
+	const float64 percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+	for (float64 percentile : percentiles) {
+		float64 expected = percentile / 100.0 * value_count * scale;
+		float64 actual = (float64)histogram_percentile(histogram, percentile);
+		if (actual < expected - scale || actual > expected * (1.0 + 1.0 / histogram_half_range) + scale) {
+			errors += "\tp" + std::to_string(percentile) + " (Expected: " + std::to_string(expected) 
+					+ ", Actual: " + std::to_string(actual) + ")\n";
+		}
+	}
+
+	verify(&errors, "Max", true, histogram->max == value_count * scale);
+	verify(&errors, "Min", true, histogram->min == scale);
+	verify(&errors, "p100", true, histogram_percentile(histogram, 100.0) == value_count * scale);
+
+	delete histogram;
+	return errors;
+}
+
+/**
+ * Push allocations of the given size into a small arena until it is full
+ */
+std::string test_arena_push(uint64 size, uint64 alignment) {
+	std::string errors = "";
+	const uint64 capacity = 1024;
+	alignas(arena_default_alignment) uint8 memory[capacity];
+	Arena arena = { memory, capacity, 0, 0, false };
+
+	uint64 push_count = 0;
+	uint8* prev = NULL;
+	while (uint8* pushed = (uint8*)arena_push(&arena, size, alignment)) {
+		if ((uintptr_t)pushed % alignment != 0 || pushed + size > memory + capacity || (prev != NULL && pushed < prev + size)) {
+			errors += "	Push " + std::to_string(push_count) + " misplaced\n";
+		}
+		prev = pushed;
+		push_count++;
+	}
+
+	uint64 stride = (size + alignment - 1) / alignment * alignment;
+	verify(&errors, "Fills arena", true, push_count == (capacity - size) / stride + 1);
+	verify(&errors, "Full arena unchanged", true, arena.used <= capacity && arena.peak == arena.used);
+
+	arena_reset(&arena);
+	verify(&errors, "Reset reuses memory", true, arena_push(&arena, size, alignment) == memory);
+	return errors;
+}
+
+std::string test_spsc_queue(int32 push_count) {
+	std::string errors = "";
+	SpscQueue<int32, 8> queue;
+	spsc_reset(&queue);
+
+	int32 item = 0;
+	verify(&errors, "Starts empty", false, spsc_pop(&queue, &item));
+
+	// Keep the queue part full so the indices wrap around the buffer
+	int32 next_push = 0;
+	int32 next_pop = 0;
+	while (next_pop < push_count) {
+		while (next_push < push_count && spsc_push(&queue, next_push)) {
+			next_push++;
+		}
+		verify(&errors, "Rejects push when full", true, next_push == push_count || next_push - next_pop == 8);
+
+		for (int32 i = 0; i < 5 && spsc_pop(&queue, &item); i++) {
+			if (item != next_pop) {
+				errors += "	Popped " + std::to_string(item) + " instead of " + std::to_string(next_pop) + "\n";
+			}
+			next_pop++;
+		}
+	}
+
+	verify(&errors, "Ends empty", false, spsc_pop(&queue, &item));
+	return errors;
+}
+
+/**
+ * Build a grid level in memory and check level_init() accepts it, then break it one way at a time
+ */
+std::string test_level_init(Vec2Int grid_size) {
+	std::string errors = "";
+	int32 tile_count = grid_size.x * grid_size.y;
+	uint64 size = level_file_size(tile_count);
+	uint8* memory = new (std::align_val_t(level_tiles_alignment)) uint8[size];
+	memset(memory, 0, size);
+
+	LevelHeader* header = (LevelHeader*)memory;
+	init_level_header(header, grid_size, tile_count, 0, Vec2(1.0f, 0.5f));
+	Tile* tiles = (Tile*)(memory + header->tiles_offset);
+	tiles[tile_count - 1].base_health = 1;
+
+	Level level = {};
+	verify(&errors, "Valid level", true, level_init(&level, memory, size));
+	verify(&errors, "Tiles after header", true, (const uint8*)level.tiles == memory + header->tiles_offset
+			&& header->tiles_offset % level_tiles_alignment == 0);
+	verify(&errors, "Truncated", false, level_init(&level, memory, size - 1));
+
+	header->grid_size_x++;
+	verify(&errors, "Grid doesn't match tiles", false, level_init(&level, memory, size));
+	header->flags = LEVEL_FREE_POSITIONS;
+	verify(&errors, "Free positions ignore grid", true, level_init(&level, memory, size));
+
+	header->tile_count++;
+	verify(&errors, "More tiles than file", false, level_init(&level, memory, size));
+	header->tile_count--;
+
+	// Only the header is read, so a file this big doesn't need to exist
+	LevelHeader too_many_tiles = *header;
+	too_many_tiles.tile_count = Game::max_grid_tile_count + 1;
+	too_many_tiles.file_size = level_file_size(too_many_tiles.tile_count);
+	too_many_tiles.tiles_offset = too_many_tiles.file_size - (uint64)too_many_tiles.tile_count * sizeof(Tile);
+	verify(&errors, "Too many tiles", false, level_init(&level, (const uint8*)&too_many_tiles, too_many_tiles.file_size));
+
+	// Only the last tile can be broken, so it's the one that makes the level valid
+	tiles[tile_count - 1].type = TILE_INDESTRUCTIBLE;
+	verify(&errors, "Only indestructible tiles", false, level_init(&level, memory, size));
+	tiles[tile_count - 1].type = TILE_NORMAL;
+	tiles[tile_count - 1].base_health = 0;
+	verify(&errors, "Only empty tiles", false, level_init(&level, memory, size));
+	tiles[tile_count - 1].base_health = 1;
+
+	header->magic = 0;
+	verify(&errors, "Bad magic", false, level_init(&level, memory, size));
+
+	operator delete[](memory, std::align_val_t(level_tiles_alignment));
+	return errors;
+}
+
+/**
+ * Play frame_count frames with a paddle that follows the ball, recording every frame into buffer 
+ * (NULL if the game records itself) and saving a snapshot of it into snapshots
+ */
+void play_recorded_frames(Game::Data* data, Game::Input* input, Game::RewindBuffer* buffer, int32 frame_count, 
+		std::vector<std::vector<uint8>>* snapshots) {
+	Game::Observation observation;
+	for (int32 i = 0; i < frame_count; i++) {
+		Game::observe(data, &observation);
+		float32 offset = observation.ball_pos.x - observation.paddle_pos_x;
+		input->left_key_pressed = offset < -0.3f;
+		input->right_key_pressed = offset > 0.3f;
+		input->start_key_pressed_prev = input->start_key_pressed;
+		input->start_key_pressed = observation.state != 1 && !input->start_key_pressed_prev;
+		Game::update(input, data);
+
+		if (buffer != NULL) {
+			Game::record_frame(buffer, data);
+		}
+		snapshots->emplace_back(Game::snapshot_size(data));
+		Game::save_snapshot(data, snapshots->back().data());
+	}
+}
+
+/**
+ * Rewind one frame at a time, checking every frame is restored byte for byte
+ */
+void verify_rewind_steps(std::string* errors, Game::Data* data, Game::RewindBuffer* buffer, int32 step_count, 
+		std::vector<std::vector<uint8>>* snapshots) {
+	std::vector<uint8> snapshot;
+	int32 mismatches = 0;
+	for (int32 i = 0; i < step_count; i++) {
+		snapshots->pop_back();
+		if (!Game::rewind(buffer, data, 1)) {
+			*errors += "\tRewind " + std::to_string(i) + " failed\n";
+			return;
+		}
+		snapshot.resize(Game::snapshot_size(data));
+		Game::save_snapshot(data, snapshot.data());
+		mismatches += snapshot != snapshots->back();
+	}
+	if (mismatches > 0) {
+		*errors += "\t" + std::to_string(mismatches) + " of " + std::to_string(step_count) + " rewound frames don't match\n";
+	}
+}
+
+/**
+ * Record a game into a buffer it doesn't own (tiles are destroyed between the recorded frames), 
+ * then rewind it part of the way, play on and rewind again
+ */
+std::string test_rewind_external_buffer(Vec2Int grid_size) {
+	std::string errors = "";
+	Game::Data* data = Game::init_headless(grid_size);
+	Game::RewindBuffer* buffer = Game::create_rewind_buffer(2000, grid_size.x * grid_size.y);
+	Game::Input input = {};
+	input.delta_time = 1.0 / 60.0;
+	std::vector<std::vector<uint8>> snapshots;
+
+	play_recorded_frames(data, &input, buffer, 600, &snapshots);
+	verify_rewind_steps(&errors, data, buffer, 300, &snapshots);
+	play_recorded_frames(data, &input, buffer, 600, &snapshots);
+	verify(&errors, "Recorded frames", true, Game::recorded_frame_count(buffer) == 900);
+	verify_rewind_steps(&errors, data, buffer, 899, &snapshots);
+
+	Game::free_rewind_buffer(buffer);
+	Game::free_headless(data);
+	return errors;
+}
+
+/**
+ * Record a game into its own buffer, then rewind it part of the way, play on and rewind again
+ */
+std::string test_rewind_own_buffer(Vec2Int grid_size) {
+	std::string errors = "";
+	Game::Data* data = Game::init_headless(grid_size);
+	Game::RewindBuffer* buffer = Game::create_rewind_buffer(2000, grid_size.x * grid_size.y);
+	Game::set_rewind_buffer(data, buffer);
+	Game::Input input = {};
+	input.delta_time = 1.0 / 60.0;
+	std::vector<std::vector<uint8>> snapshots;
+
+	play_recorded_frames(data, &input, NULL, 600, &snapshots);
+	verify_rewind_steps(&errors, data, buffer, 300, &snapshots);
+	play_recorded_frames(data, &input, NULL, 600, &snapshots);
+	verify(&errors, "Recorded frames", true, Game::recorded_frame_count(buffer) == 900);
+	verify_rewind_steps(&errors, data, buffer, 899, &snapshots);
+
+	Game::free_headless(data);
+	Game::free_rewind_buffer(buffer);
+	return errors;
+}
+
+/**
+ * Save a snapshot part way through a game, load it after playing on and check the game picks up from it the same way
+ */
+std::string test_snapshot_round_trip(Vec2Int grid_size) {
+	std::string errors = "";
+	Game::Data* data = Game::init_headless(grid_size);
+	Game::Input input = {};
+	input.delta_time = 1.0 / 60.0;
+	std::vector<std::vector<uint8>> snapshots;
+
+	play_recorded_frames(data, &input, NULL, 300, &snapshots);
+	std::vector<uint8> saved = snapshots.back();
+	Game::Input saved_input = input;
+	play_recorded_frames(data, &input, NULL, 300, &snapshots);
+
+	Game::load_snapshot(data, saved.data());
+	std::vector<uint8> loaded(Game::snapshot_size(data));
+	Game::save_snapshot(data, loaded.data());
+	verify(&errors, "Loaded snapshot matches", true, loaded == saved);
+
+	std::vector<std::vector<uint8>> replayed;
+	play_recorded_frames(data, &saved_input, NULL, 300, &replayed);
+	verify(&errors, "Plays on the same way", true, std::equal(replayed.begin(), replayed.end(), snapshots.begin() + 300));
+
+	Game::free_headless(data);
+	return errors;
+}
+
+/**
+ * Load a level with tiles of every kind into a game, play it and rewind back across the load
+ */
+std::string test_load_level(Vec2Int grid_size) {
+	std::string errors = "";
+	int32 tile_count = grid_size.x * grid_size.y;
+	uint64 size = level_file_size(tile_count);
+	uint8* memory = new (std::align_val_t(level_tiles_alignment)) uint8[size];
+	memset(memory, 0, size);
+
+	LevelHeader* header = (LevelHeader*)memory;
+	init_level_header(header, grid_size, tile_count, 0, Vec2(1.0f, 0.5f));
+	Tile* tiles = (Tile*)(memory + header->tiles_offset);
+	for (int32 i = 0; i < tile_count; i++) {
+		tiles[i].pos = Vec2((float32)(i % grid_size.x) - grid_size.x * 0.5f, 4.0f - (float32)(i / grid_size.x) * 0.5f);
+		tiles[i].base_health = (uint16)(i % 3);
+		tiles[i].health = tiles[i].base_health;
+		tiles[i].type = i % 7 == 3 ? TILE_INDESTRUCTIBLE : TILE_NORMAL;
+	}
+	Level level = {};
+	verify(&errors, "Valid level", true, level_init(&level, memory, size));
+
+	Game::Data* data = Game::init_headless(grid_size);
+	Game::RewindBuffer* buffer = Game::create_rewind_buffer(1000, tile_count);
+	Game::set_rewind_buffer(data, buffer);
+	Game::Input input = {};
+	input.delta_time = 1.0 / 60.0;
+	std::vector<std::vector<uint8>> snapshots;
+	play_recorded_frames(data, &input, NULL, 300, &snapshots);
+
+	verify(&errors, "Loads", true, Game::load_level(data, &level));
+	Game::Observation observation;
+	Game::observe(data, &observation);
+	verify(&errors, "Paused on level 1", true, observation.state == 0 && observation.level == 1);
+	int32 observed_tile_count = std::min(tile_count, Game::observation_tile_capacity);
+	int32 tiles_matching = 0;
+	for (int32 i = 0; i < observation.tile_count; i++) {
+		tiles_matching += observation.tile_health[i] == tiles[i].base_health;
+	}
+	verify(&errors, "Tiles from level", true, observation.tile_count == observed_tile_count && tiles_matching == observed_tile_count);
+
+	play_recorded_frames(data, &input, NULL, 300, &snapshots);
+	verify_rewind_steps(&errors, data, buffer, 599, &snapshots);
+
+	// A game only has room for the tiles of its own grid
+	Game::Data* smaller = Game::init_headless(Vec2Int(grid_size.x, grid_size.y - 1));
+	verify(&errors, "Too many tiles for game", false, Game::load_level(smaller, &level));
+
+	Game::free_headless(smaller);
+	Game::free_headless(data);
+	Game::free_rewind_buffer(buffer);
+	operator delete[](memory, std::align_val_t(level_tiles_alignment));
+	return errors;
+}
+
 int main() {
 	bool has_failed = false;
 	std::cout << std::endl << "Running Tests..." << std::endl << std::endl; 
@@ -88,6 +459,57 @@ int main() {
 
 	test(&has_failed, "Raycast Circle Test 3", test_raycast_circle_miss(Vec2(0.0f, 0.0f), normalize(Vec2(1.0f, 1.0f)), Vec2(-2.0f, -2.0f), 1.0f));
 
+	//
+	// delta_encode() / delta_apply()
+	//
+	test(&has_failed, "Delta Round Trip Sparse", test_delta_round_trip(472, 97));
+	test(&has_failed, "Delta Round Trip Dense", test_delta_round_trip(472, 1));
+	test(&has_failed, "Delta Round Trip Alternating", test_delta_round_trip(1000, 3));
+	test(&has_failed, "Delta Round Trip Unchanged", test_delta_round_trip(300, 1000));
+
+	//
+	// histogram_record() / histogram_percentile()
+	//
+	test(&has_failed, "Histogram Percentiles Small", test_histogram_percentiles(50, 1));
+	test(&has_failed, "Histogram Percentiles Nanoseconds", test_histogram_percentiles(100000, 997));
+	test(&has_failed, "Histogram Percentiles Large", test_histogram_percentiles(1000, 1ull << 50));
+
+	//
+	// arena_push()
+	//
+	test(&has_failed, "Arena Push Cache Line Aligned", test_arena_push(40, arena_default_alignment));
+	test(&has_failed, "Arena Push Unaligned", test_arena_push(7, 1));
+
+	//
+	// spsc_push() / spsc_pop()
+	//
+	test(&has_failed, "SPSC Queue Wrap Around", test_spsc_queue(100));
+
+	//
+	// level_init()
+	//
+	test(&has_failed, "Level Init Default Grid", test_level_init(Vec2Int(12, 3)));
+	test(&has_failed, "Level Init Large Grid", test_level_init(Vec2Int(1000, 1000)));
+
+	//
+	// record_frame() / rewind()
+	//
+	test(&has_failed, "Rewind External Buffer", test_rewind_external_buffer(Vec2Int(12, 3)));
+	test(&has_failed, "Rewind External Buffer Wide Grid", test_rewind_external_buffer(Vec2Int(24, 6)));
+	test(&has_failed, "Rewind Own Buffer", test_rewind_own_buffer(Vec2Int(12, 3)));
+	test(&has_failed, "Rewind Own Buffer Wide Grid", test_rewind_own_buffer(Vec2Int(24, 6)));
+
+	//
+	// save_snapshot() / load_snapshot()
+	//
+	test(&has_failed, "Snapshot Round Trip", test_snapshot_round_trip(Vec2Int(12, 3)));
+
+	//
+	// load_level()
+	//
+	test(&has_failed, "Load Level", test_load_level(Vec2Int(12, 3)));
+	test(&has_failed, "Load Level Wide Grid", test_load_level(Vec2Int(24, 6)));
+
 
 	if (has_failed) {
 		std::cout << std::endl << RED_TEXT << "Tests failed." << RESET_TEXT << std::endl << std::endl;
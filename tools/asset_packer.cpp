@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../src/assetpack.hpp"
+
+/**
+ * Build an asset pack (see src/assetpack.hpp) from every file in a directory.
+ *
+ * Usage: asset_packer [--cpp] <assets directory> <output>
+ * - --cpp: Write the pack as C++ source defining embedded_asset_pack instead,
+ *   for builds with EMBED_ASSETS that compile the assets into the executable
+ */
+
+struct PackedAsset {
+	std::string        name;
+	std::vector<uint8> data;
+};
+
+/**
+ * Read a whole file
+ * @returns False if the file couldn't be read
+ */
+bool read_asset_file(const std::filesystem::path& path, std::vector<uint8>* data) {
+	FILE* file = fopen(path.string().c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	fseek(file, 0L, SEEK_END);
+	long size = ftell(file);
+	rewind(file);
+
+	data->resize(size > 0 ? size : 0);
+	bool ok = size >= 0 && fread(data->data(), 1, data->size(), file) == data->size();
+	fclose(file);
+	return ok;
+}
+
+/**
+ * Write the pack as a C++ array (see embedded_asset_pack in assetpack.hpp)
+ * @returns False if the file couldn't be written
+ */
+bool write_pack_source(const char* path, const std::vector<uint8>& pack) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "// Generated by tools/asset_packer.cpp, do not edit\n\n");
+	fprintf(file, "#include \"assetpack.hpp\"\n\n");
+	fprintf(file, "alignas(asset_pack_alignment) extern const uint8 embedded_asset_pack[] = {");
+	for (size_t i = 0; i < pack.size(); i++) {
+		fprintf(file, i % 16 == 0 ? "\n\t0x%02x," : " 0x%02x,", pack[i]);
+	}
+	fprintf(file, "\n};\n\n");
+	fprintf(file, "extern const uint64 embedded_asset_pack_size = %llu;\n", (unsigned long long)pack.size());
+	return fclose(file) == 0;
+}
+
+uint64 align_offset(uint64 offset) {
+	return (offset + asset_pack_alignment - 1) / asset_pack_alignment * asset_pack_alignment;
+}
+
+int main(int argc, char** argv) {
+	bool write_source = argc == 4 && strcmp(argv[1], "--cpp") == 0;
+	if (argc != 3 && !write_source) {
+		std::cout << "Usage: asset_packer [--cpp] <assets directory> <output>" << std::endl;
+		return 1;
+	}
+
+	std::filesystem::path assets_path = argv[argc - 2];
+	const char* pack_path = argv[argc - 1];
+
+	//
+	// Read every asset
+	//
+	std::vector<PackedAsset> assets;
+	std::error_code error;
+	for (std::filesystem::recursive_directory_iterator it(assets_path, error), end; !error && it != end; it.increment(error)) {
+		if (!it->is_regular_file()) {
+			continue;
+		}
+
+		PackedAsset asset;
+		asset.name = it->path().lexically_relative(assets_path).generic_string();
+		if (asset.name.size() >= (size_t)asset_pack_name_capacity) {
+			std::cout << "Asset name is too long (max " << asset_pack_name_capacity - 1 << " characters): " << asset.name << std::endl;
+			return 1;
+		}
+
+		if (!read_asset_file(it->path(), &asset.data)) {
+			std::cout << "Failed to read asset: " << it->path().string() << std::endl;
+			return 1;
+		}
+		assets.push_back(asset);
+	}
+
+	if (error) {
+		std::cout << "Failed to read assets directory: " << assets_path.string() << std::endl;
+		return 1;
+	}
+
+	// The runtime binary searches the index
+	std::sort(assets.begin(), assets.end(), [](const PackedAsset& a, const PackedAsset& b) {
+		return strcmp(a.name.c_str(), b.name.c_str()) < 0;
+	});
+
+	//
+	// Lay out the pack
+	//
+	std::vector<AssetPackEntry> entries(assets.size());
+	uint64 offset = sizeof(AssetPackHeader) + sizeof(AssetPackEntry) * assets.size();
+	for (size_t i = 0; i < assets.size(); i++) {
+		AssetPackEntry* entry = &entries[i];
+		memset(entry, 0, sizeof(AssetPackEntry));
+		strcpy(entry->name, assets[i].name.c_str());
+		entry->offset = align_offset(offset);
+		entry->size = assets[i].data.size();
+		entry->checksum = asset_checksum(assets[i].data.data(), entry->size);
+		offset = entry->offset + entry->size + 1; // Null terminator
+	}
+
+	AssetPackHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = asset_pack_magic;
+	header.version = asset_pack_version;
+	header.asset_count = (uint32)assets.size();
+	header.file_size = offset;
+
+	std::vector<uint8> pack(offset, 0);
+	memcpy(pack.data(), &header, sizeof(header));
+	if (!entries.empty()) {
+		memcpy(pack.data() + sizeof(header), entries.data(), sizeof(AssetPackEntry) * entries.size());
+	}
+	for (size_t i = 0; i < assets.size(); i++) {
+		if (!assets[i].data.empty()) {
+			memcpy(pack.data() + entries[i].offset, assets[i].data.data(), assets[i].data.size());
+		}
+	}
+
+	//
+	// Write it
+	//
+	bool ok;
+	if (write_source) {
+		ok = write_pack_source(pack_path, pack);
+	} else {
+		FILE* file = fopen(pack_path, "wb");
+		ok = file != NULL && fwrite(pack.data(), 1, pack.size(), file) == pack.size();
+		ok = file != NULL && fclose(file) == 0 && ok;
+	}
+
+	if (!ok) {
+		std::cout << "Failed to write asset pack: " << pack_path << std::endl;
+		return 1;
+	}
+
+	std::cout << "Packed " << assets.size() << " assets (" << pack.size() << " bytes) into " << pack_path << std::endl;
+	return 0;
+}
@@ -0,0 +1,563 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/collision.hpp"
+#include "../src/gamecommon.hpp"
+#include "../src/level.hpp"
+
+/**
+ * Generate level files (see src/level.hpp) from a seed, the same seed and
+ * options always give the same level.
+ *
+ * Every level is checked by bouncing balls around it (with the swept tests in
+ * src/collision.hpp), the paddle sends the ball back up at a random angle each
+ * time it comes down, and it's only valid if every breakable tile can be hit. A hit opens the tile up right away whatever its health, health
+ * only changes how long a level takes and not which tiles can be reached.
+ *
+ * Usage: level_generator [options] <output file>
+ *        level_generator [options] --batch <count> <output directory>
+ * - --seed <n>: Seed of the level, batch levels use seed, seed + 1, ... (default 1)
+ * - --grid <columns>x<rows>: Size of the tile grid (default 12x3)
+ * - --pattern <name>: Which cells have a tile, full, checker, stripes, diamond, pyramid, noise or any (default any)
+ * - --symmetry <name>: none, mirror (left to right), quad (also top to bottom) or any (default any)
+ * - --gradient <name>: How health is spread, flat, rows (toughest at the top), center or any (default any)
+ * - --max-health <n>: Base health of the toughest tiles (default 3)
+ * - --indestructible <fraction>: Chance of a tile being indestructible (default 0.05)
+ * - --threads <n>: Batch worker threads (default one per core)
+ *
+ * Options set to any are picked from the seed. The batch mode writes
+ * level_<seed>.level for every valid level and levels.csv with the stats
+ * of every level (valid or not) for difficulty balancing.
+ */
+
+enum Pattern   { PATTERN_FULL, PATTERN_CHECKER, PATTERN_STRIPES, PATTERN_DIAMOND, PATTERN_PYRAMID, PATTERN_NOISE, PATTERN_COUNT };
+enum Symmetry  { SYMMETRY_NONE, SYMMETRY_MIRROR, SYMMETRY_QUAD, SYMMETRY_COUNT };
+enum Gradient  { GRADIENT_FLAT, GRADIENT_ROWS, GRADIENT_CENTER, GRADIENT_COUNT };
+
+const char* const pattern_names[]  = { "full", "checker", "stripes", "diamond", "pyramid", "noise" };
+const char* const symmetry_names[] = { "none", "mirror", "quad" };
+const char* const gradient_names[] = { "flat", "rows", "center" };
+
+// Picked from the seed
+const int32 option_any = -1;
+
+// Balls launched up from the paddle line per validation round, the paddle sends them back up within the max angle
+const int32   validation_launch_count   = 16;
+const float32 validation_max_angle      = 60.0f * (PI / 180.0f);
+const int32   validation_max_bounces    = 128;
+const int32   validation_max_rounds     = 64;
+
+struct GeneratorOptions {
+	uint32  seed;
+	Vec2Int grid_size;
+	int32   pattern;  // Pattern or option_any
+	int32   symmetry; // Symmetry or option_any
+	int32   gradient; // Gradient or option_any
+	int32   max_health;
+	float32 indestructible_chance;
+};
+
+struct GeneratedLevel {
+	uint32   seed;
+	Pattern  pattern;
+	Symmetry symmetry;
+	Gradient gradient;
+	Vec2     tile_size;
+
+	std::vector<Tile> tiles;
+};
+
+// Results of validate_level()
+struct LevelStats {
+	int32 breakable_count;
+	int32 indestructible_count;
+	int32 total_health;
+	int32 reached_count; // Breakable tiles the balls hit
+	int32 rounds;        // Rounds of launches until nothing else was hit
+	int32 bounces;       // Bounces off tiles in every round, a rough measure of how long the level takes to clear
+	bool  valid;
+};
+
+//
+// Generation
+//
+
+/**
+ * Random number from 0 to 1 for a cell, the same for the same seed, salt and cell
+ */
+float32 cell_random(uint32 seed, uint32 salt, int32 x, int32 y) {
+	uint32 state = seed * 0x9E3779B9u ^ salt * 0x85EBCA6Bu ^ (uint32)x * 0xC2B2AE35u ^ (uint32)y * 0x27D4EB2Fu;
+	state ^= state >> 16;
+	if (state == 0) {
+		state = 1;
+	}
+
+	// A few rounds so neighbouring cells aren't related
+	random_float(&state);
+	random_float(&state);
+	return random_float(&state);
+}
+
+/**
+ * Pick an option from the seed if it's set to any
+ */
+int32 resolve_option(int32 option, int32 count, uint32 seed, uint32 salt) {
+	if (option != option_any) {
+		return option;
+	}
+	return (int32)(cell_random(seed, salt, 0, 0) * count) % count;
+}
+
+/**
+ * Check if a cell has a tile, cells are in 0 to 1 coordinates (u, v) with v = 0 at the top
+ */
+bool pattern_has_tile(Pattern pattern, uint32 seed, int32 x, int32 y, Vec2Int grid_size) {
+	float32 u = grid_size.x > 1 ? (float32)x / (float32)(grid_size.x - 1) : 0.5f;
+	float32 v = grid_size.y > 1 ? (float32)y / (float32)(grid_size.y - 1) : 0.5f;
+
+	switch (pattern) {
+		case PATTERN_FULL:    return true;
+		case PATTERN_CHECKER: return (x + y) % 2 == 0;
+		case PATTERN_STRIPES: return y % 2 == 0;
+		case PATTERN_DIAMOND: return fabsf(u - 0.5f) + fabsf(v - 0.5f) <= 0.5f;
+		case PATTERN_PYRAMID: return fabsf(u - 0.5f) * 2.0f <= (float32)(y + 1) / (float32)grid_size.y;
+		case PATTERN_NOISE: {
+			// Every level gets its own density so some are sparse and some are packed
+			float32 density = 0.5f + 0.4f * cell_random(seed, 1, -1, -1);
+			return cell_random(seed, 2, x, y) < density;
+		}
+		default: return false;
+	}
+}
+
+/**
+ * Base health of a tile from 0 to 1 along the gradient
+ */
+float32 gradient_amount(Gradient gradient, int32 x, int32 y, Vec2Int grid_size) {
+	float32 u = grid_size.x > 1 ? (float32)x / (float32)(grid_size.x - 1) : 0.5f;
+	float32 v = grid_size.y > 1 ? (float32)y / (float32)(grid_size.y - 1) : 0.5f;
+
+	switch (gradient) {
+		case GRADIENT_ROWS:   return 1.0f - v;
+		case GRADIENT_CENTER: return 1.0f - fminf(1.0f, (fabsf(u - 0.5f) + fabsf(v - 0.5f)) * 2.0f);
+		default:              return 0.0f;
+	}
+}
+
+void generate_level(const GeneratorOptions* options, uint32 seed, GeneratedLevel* level) {
+	Vec2Int grid_size = options->grid_size;
+	level->seed = seed;
+	level->pattern = (Pattern)resolve_option(options->pattern, PATTERN_COUNT, seed, 10);
+	level->symmetry = (Symmetry)resolve_option(options->symmetry, SYMMETRY_COUNT, seed, 11);
+	level->gradient = (Gradient)resolve_option(options->gradient, GRADIENT_COUNT, seed, 12);
+	level->tile_size = grid_fit_tile_size(grid_size);
+	level->tiles.resize((size_t)grid_size.x * grid_size.y);
+
+	for (int32 i = 0; i < (int32)level->tiles.size(); i++) {
+		int32 x = i % grid_size.x;
+		int32 y = i / grid_size.x;
+
+		// Mirrored cells use the same cell for every random choice so they come out the same
+		int32 cell_x = x;
+		int32 cell_y = y;
+		if (level->symmetry != SYMMETRY_NONE && cell_x >= (grid_size.x + 1) / 2) {
+			cell_x = grid_size.x - 1 - cell_x;
+		}
+		if (level->symmetry == SYMMETRY_QUAD && cell_y >= (grid_size.y + 1) / 2) {
+			cell_y = grid_size.y - 1 - cell_y;
+		}
+
+		// Cells without a tile keep a base health of 0
+		Tile* tile = &level->tiles[i];
+		tile->pos = grid_tile_position(grid_size, level->tile_size, i);
+		tile->health = 0;
+		tile->base_health = 0;
+		tile->type = TILE_NORMAL;
+		if (!pattern_has_tile(level->pattern, seed, cell_x, cell_y, grid_size)) {
+			continue;
+		}
+
+		if (cell_random(seed, 3, cell_x, cell_y) < options->indestructible_chance) {
+			tile->type = TILE_INDESTRUCTIBLE;
+			tile->base_health = 1;
+		} else {
+			// The gradient uses the real cell, quad symmetry already mirrors it top to bottom
+			float32 amount = gradient_amount(level->gradient, x, y, grid_size);
+			tile->base_health = (uint16)(1 + (int32)(amount * (options->max_health - 1) + 0.5f));
+		}
+		tile->health = tile->base_health;
+	}
+}
+
+//
+// Validation
+//
+
+/**
+ * Direction the paddle sends the ball up in, a player can aim anywhere in the max angle
+ */
+Vec2 random_launch_direction(uint32* random_state) {
+	return rotate(Vec2(0.0f, 1.0f), validation_max_angle * (2.0f * random_float(random_state) - 1.0f));
+}
+
+/**
+ * Follow a ball for validation_max_bounces bounces, breakable tiles it hits are marked as hit and stop blocking
+ * @returns Bounces off tiles
+ */
+int32 trace_validation_ball(const GeneratedLevel* level, Vec2 start, uint32* random_state, std::vector<uint8>* hit) {
+	const float32 segment_length = world_size.x + world_size.y;
+	const float32 paddle_top = paddle_pos_y + paddle_size.y * 0.5f;
+	Vec2 pos = start;
+	Vec2 vel = random_launch_direction(random_state);
+	int32 tile_bounces = 0;
+
+	for (int32 bounce = 0; bounce < validation_max_bounces; bounce++) {
+		Vec2 end = pos + normalize(vel) * segment_length;
+
+		float32 closest_distance = INFINITY;
+		Vec2 closest_point, closest_normal;
+		int32 closest_tile = -1;
+
+		float32 distance;
+		Vec2 point, normal;
+		if (moving_circle_to_vertical_line_collision_check(pos, end, ball_radius, world_size.x * 0.5f, &distance, &point, &normal)
+				&& distance < closest_distance)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+		}
+		if (moving_circle_to_vertical_line_collision_check(pos, end, ball_radius, -world_size.x * 0.5f, &distance, &point, &normal)
+				&& distance < closest_distance)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+		}
+		if (moving_circle_to_horizontal_line_collision_check(pos, end, ball_radius, world_size.y * 0.5f, &distance, &point, &normal)
+				&& distance < closest_distance)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+		}
+
+		// The paddle is taken to be wherever the ball comes down
+		bool hit_paddle = false;
+		if (moving_circle_to_horizontal_line_collision_check(pos, end, ball_radius, paddle_top, &distance, &point, &normal)
+				&& distance < closest_distance && normal.y > 0.0f)
+		{
+			closest_distance = distance;
+			closest_point = point;
+			closest_normal = normal;
+			hit_paddle = true;
+		}
+
+		for (int32 i = 0; i < (int32)level->tiles.size(); i++) {
+			if (level->tiles[i].health < 1 || (*hit)[i]) {
+				continue;
+			}
+			if (moving_circle_to_retangle_collision_check(pos, end, ball_radius, level->tiles[i].pos, level->tile_size,
+					&distance, &point, &normal) && distance < closest_distance)
+			{
+				closest_distance = distance;
+				closest_point = point;
+				closest_normal = normal;
+				closest_tile = i;
+				hit_paddle = false;
+			}
+		}
+
+		// Only happens if the ball is stuck between the paddle line and a tile
+		if (closest_distance == INFINITY) {
+			break;
+		}
+
+		if (closest_tile >= 0) {
+			tile_bounces++;
+			if (level->tiles[closest_tile].type == TILE_NORMAL) {
+				(*hit)[closest_tile] = 1;
+			}
+		}
+
+		vel = hit_paddle ? random_launch_direction(random_state) : reflect(vel, closest_normal);
+		pos = closest_point;
+	}
+	return tile_bounces;
+}
+
+/**
+ * Launch rounds of balls from the paddle line until every breakable tile is hit or a round hits nothing new
+ */
+void validate_level(const GeneratedLevel* level, LevelStats* stats) {
+	memset(stats, 0, sizeof(LevelStats));
+
+	int32 tile_count = (int32)level->tiles.size();
+	std::vector<uint8> hit(tile_count, 0);
+	for (int32 i = 0; i < tile_count; i++) {
+		const Tile* tile = &level->tiles[i];
+		if (tile->health < 1) {
+			continue;
+		}
+
+		if (tile->type == TILE_NORMAL) {
+			stats->breakable_count++;
+			stats->total_health += tile->health;
+		} else {
+			stats->indestructible_count++;
+		}
+	}
+
+	// Seeded by the level so validating it again gives the same stats
+	uint32 random_state = level->seed * 0x9E3779B9u + 1;
+	if (random_state == 0) {
+		random_state = 1;
+	}
+
+	const float32 launch_y = paddle_pos_y + paddle_size.y * 0.5f + ball_radius + 0.01f;
+	const float32 launch_range_x = (world_size.x - paddle_size.x) * 0.5f;
+	while (stats->reached_count < stats->breakable_count && stats->rounds < validation_max_rounds) {
+		for (int32 i = 0; i < validation_launch_count; i++) {
+			float32 t = (float32)i / (float32)(validation_launch_count - 1);
+			Vec2 start = Vec2(-launch_range_x + 2.0f * launch_range_x * t, launch_y);
+			stats->bounces += trace_validation_ball(level, start, &random_state, &hit);
+		}
+		stats->rounds++;
+
+		int32 reached_count = 0;
+		for (int32 i = 0; i < tile_count; i++) {
+			reached_count += hit[i];
+		}
+		if (reached_count == stats->reached_count) {
+			break;
+		}
+		stats->reached_count = reached_count;
+	}
+
+	stats->valid = stats->breakable_count > 0 && stats->reached_count == stats->breakable_count;
+}
+
+//
+// Output
+//
+
+/**
+ * Write a level file
+ * @returns False if the file couldn't be written
+ */
+bool write_level(const char* path, const GeneratedLevel* level, Vec2Int grid_size) {
+	int32 tile_count = (int32)level->tiles.size();
+	std::vector<uint8> data(level_file_size(tile_count), 0);
+	LevelHeader* header = (LevelHeader*)data.data();
+	init_level_header(header, grid_size, tile_count, 0, level->tile_size);
+	memcpy(data.data() + header->tiles_offset, level->tiles.data(), (size_t)tile_count * sizeof(Tile));
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	return fclose(file) == 0 && ok;
+}
+
+void print_level_stats(const GeneratedLevel* level, const LevelStats* stats) {
+	std::cout << "Seed " << level->seed << ": " << pattern_names[level->pattern] << ", " << symmetry_names[level->symmetry]
+			<< " symmetry, " << gradient_names[level->gradient] << " gradient, " << stats->breakable_count << " breakable and "
+			<< stats->indestructible_count << " indestructible tiles, total health " << stats->total_health << ", reached "
+			<< stats->reached_count << " in " << stats->rounds << " rounds (" << stats->bounces << " bounces)" << std::endl;
+}
+
+struct BatchResult {
+	GeneratedLevel level;
+	LevelStats     stats;
+	bool           written;
+};
+
+/**
+ * Generate, validate and write levels until the shared counter runs out
+ */
+void batch_worker(const GeneratorOptions* options, std::filesystem::path directory, int32 count,
+		std::atomic<int32>* next, std::vector<BatchResult>* results)
+{
+	while (true) {
+		int32 index = next->fetch_add(1, std::memory_order_relaxed);
+		if (index >= count) {
+			return;
+		}
+
+		BatchResult* result = &(*results)[index];
+		generate_level(options, options->seed + (uint32)index, &result->level);
+		validate_level(&result->level, &result->stats);
+
+		result->written = false;
+		if (result->stats.valid) {
+			std::string name = "level_" + std::to_string(result->level.seed) + ".level";
+			result->written = write_level((directory / name).string().c_str(), &result->level, options->grid_size);
+		}
+
+		// The tiles are in the file now, only the stats are needed for the manifest
+		std::vector<Tile>().swap(result->level.tiles);
+	}
+}
+
+/**
+ * Look up an option name
+ * @returns option_any for "any", less than option_any if the name isn't known
+ */
+int32 parse_option_name(const char* name, const char* const* names, int32 count) {
+	if (strcmp(name, "any") == 0) {
+		return option_any;
+	}
+	for (int32 i = 0; i < count; i++) {
+		if (strcmp(name, names[i]) == 0) {
+			return i;
+		}
+	}
+	return option_any - 1;
+}
+
+int main(int argc, char** argv) {
+	GeneratorOptions options;
+	options.seed = 1;
+	options.grid_size = default_tile_grid_size;
+	options.pattern = option_any;
+	options.symmetry = option_any;
+	options.gradient = option_any;
+	options.max_health = 3;
+	options.indestructible_chance = 0.05f;
+
+	int32 batch_count = 0;
+	int32 thread_count = (int32)std::thread::hardware_concurrency();
+	const char* output_path = NULL;
+	bool options_ok = true;
+	for (int i = 1; i < argc && options_ok; i++) {
+		bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--seed") == 0 && has_value) {
+			options.seed = (uint32)strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--grid") == 0 && has_value) {
+			options_ok = sscanf(argv[++i], "%dx%d", &options.grid_size.x, &options.grid_size.y) == 2;
+		} else if (strcmp(argv[i], "--pattern") == 0 && has_value) {
+			options.pattern = parse_option_name(argv[++i], pattern_names, PATTERN_COUNT);
+		} else if (strcmp(argv[i], "--symmetry") == 0 && has_value) {
+			options.symmetry = parse_option_name(argv[++i], symmetry_names, SYMMETRY_COUNT);
+		} else if (strcmp(argv[i], "--gradient") == 0 && has_value) {
+			options.gradient = parse_option_name(argv[++i], gradient_names, GRADIENT_COUNT);
+		} else if (strcmp(argv[i], "--max-health") == 0 && has_value) {
+			options.max_health = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--indestructible") == 0 && has_value) {
+			options.indestructible_chance = (float32)atof(argv[++i]);
+		} else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+			thread_count = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--batch") == 0 && has_value) {
+			batch_count = atoi(argv[++i]);
+			options_ok = batch_count > 0;
+		} else if (argv[i][0] != '-' && output_path == NULL) {
+			output_path = argv[i];
+		} else {
+			options_ok = false;
+		}
+	}
+
+	// Health is stored in 16 bits and multiplied by the level number in game
+	options_ok = options_ok && options.grid_size.x > 0 && options.grid_size.y > 0
+			&& (int64)options.grid_size.x * options.grid_size.y <= Game::max_grid_tile_count
+			&& options.pattern >= option_any && options.symmetry >= option_any && options.gradient >= option_any
+			&& options.max_health >= 1 && options.max_health <= 1000;
+	if (!options_ok || output_path == NULL) {
+		std::cout << "Usage: level_generator [options] <output file>" << std::endl;
+		std::cout << "       level_generator [options] --batch <count> <output directory>" << std::endl;
+		std::cout << "See tools/level_generator.cpp for the options." << std::endl;
+		return 1;
+	}
+
+	//
+	// Single level
+	//
+	if (batch_count == 0) {
+		GeneratedLevel level;
+		LevelStats stats;
+		generate_level(&options, options.seed, &level);
+		validate_level(&level, &stats);
+		print_level_stats(&level, &stats);
+		if (!stats.valid) {
+			std::cout << "Warning: " << stats.breakable_count - stats.reached_count << " breakable tiles can't be reached." << std::endl;
+		}
+
+		if (!write_level(output_path, &level, options.grid_size)) {
+			std::cout << "Failed to write level: " << output_path << std::endl;
+			return 1;
+		}
+		std::cout << "Wrote level to " << output_path << std::endl;
+		return 0;
+	}
+
+	//
+	// Batch, levels are handed out one at a time so slow levels don't hold up a whole thread
+	//
+	std::filesystem::path directory = output_path;
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		std::cout << "Failed to create output directory: " << output_path << std::endl;
+		return 1;
+	}
+
+	if (thread_count < 1) {
+		thread_count = 1;
+	}
+	if (thread_count > batch_count) {
+		thread_count = batch_count;
+	}
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	std::vector<BatchResult> results(batch_count);
+	std::atomic<int32> next(0);
+	std::vector<std::thread> threads;
+	for (int32 i = 0; i < thread_count; i++) {
+		threads.emplace_back(batch_worker, &options, directory, batch_count, &next, &results);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	float64 seconds = std::chrono::duration<float64>(std::chrono::steady_clock::now() - start_time).count();
+
+	// The manifest is written in seed order so it doesn't depend on the thread count
+	std::string manifest_path = (directory / "levels.csv").string();
+	FILE* manifest = fopen(manifest_path.c_str(), "w");
+	if (manifest == NULL) {
+		std::cout << "Failed to write manifest: " << manifest_path << std::endl;
+		return 1;
+	}
+
+	fprintf(manifest, "seed,file,pattern,symmetry,gradient,breakable,indestructible,total_health,reached,rounds,bounces,valid\n");
+	int32 valid_count = 0;
+	int32 write_failures = 0;
+	for (const BatchResult& result : results) {
+		const LevelStats* stats = &result.stats;
+		valid_count += stats->valid;
+		write_failures += stats->valid && !result.written;
+
+		std::string name = result.written ? "level_" + std::to_string(result.level.seed) + ".level" : "";
+		fprintf(manifest, "%u,%s,%s,%s,%s,%d,%d,%d,%d,%d,%d,%d\n", result.level.seed, name.c_str(),
+				pattern_names[result.level.pattern], symmetry_names[result.level.symmetry], gradient_names[result.level.gradient],
+				stats->breakable_count, stats->indestructible_count, stats->total_health, stats->reached_count,
+				stats->rounds, stats->bounces, stats->valid ? 1 : 0);
+	}
+	bool manifest_ok = fclose(manifest) == 0;
+
+	std::cout << "Generated " << batch_count << " levels (" << valid_count << " valid) in " << seconds << "s with "
+			<< thread_count << " threads, wrote " << manifest_path << std::endl;
+	if (write_failures > 0 || !manifest_ok) {
+		std::cout << "Failed to write " << write_failures << " levels." << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -6,7 +6,7 @@ mkdir bin\win-debug
 if %errorlevel% neq 0 exit /b %errorlevel%
 
 :: Compile tests with mingw64
-g++ -o bin\win-debug\BreakoutCppWin_tests.exe tests\*.cpp -DWINDOWS -Wall -O0 -g
+g++ -o bin\win-debug\BreakoutCppWin_tests.exe tests\*.cpp src\game.cpp src\lanes.cpp src\metrics.cpp third-party\src\*.c -DWINDOWS -Ithird-party\include -std=c++17 -Wall -O0 -g
 if %errorlevel% neq 0 exit /b %errorlevel%
 
 :: Run tests
@@ -17,10 +17,13 @@ if %errorlevel% neq 0 exit /b %errorlevel%
 set /p version=<version.txt
 
 :: Compile with mingw64
-g++ -o bin\win-debug\BreakoutCppWin_debug.exe src\*.cpp third-party\src\*.c -DWINDOWS -DVERSION=\"%version%-debug\" -Ithird-party\include -Lthird-party\lib-win -lglfw3 -lgdi32 -Wall -O0 -g
+g++ -o bin\win-debug\BreakoutCppWin_debug.exe src\*.cpp third-party\src\*.c -DWINDOWS -DPROFILER -DALLOC_TRACKING -DVERSION=\"%version%-debug\" -Ithird-party\include -Lthird-party\lib-win -lglfw3 -lgdi32 -std=c++17 -Wall -O0 -g
 if %errorlevel% neq 0 exit /b %errorlevel%
 
-:: Copy shaders to bin\win-debug
-robocopy assets\shaders bin\win-debug\shaders > nul
+:: Pack assets into bin\win-debug\assets.pack
+g++ -o bin\win-debug\asset_packer.exe tools\asset_packer.cpp -DWINDOWS -std=c++17 -Wall -O2
+if %errorlevel% neq 0 exit /b %errorlevel%
+bin\win-debug\asset_packer.exe assets bin\win-debug\assets.pack
+if %errorlevel% neq 0 exit /b %errorlevel%
 
 exit 0
\ No newline at end of file
@@ -7,11 +7,28 @@ set /p version=<version.txt
 if exist bin\win-release rmdir /S /Q bin\win-release
 mkdir bin\win-release
 
+:: Pack assets into bin\win-release\assets.pack, or compile them into the executable with --embed-assets
+g++ -o bin\win-release\asset_packer.exe tools\asset_packer.cpp -DWINDOWS -std=c++17 -Wall -O2
+if %errorlevel% neq 0 exit /b %errorlevel%
+set embed_flags=
+if "%1"=="--embed-assets" (
+	bin\win-release\asset_packer.exe --cpp assets bin\win-release\embedded_assets.cpp
+	set embed_flags=bin\win-release\embedded_assets.cpp -DEMBED_ASSETS -Isrc
+) else (
+	bin\win-release\asset_packer.exe assets bin\win-release\assets.pack
+)
+if %errorlevel% neq 0 exit /b %errorlevel%
+
 :: Compile with mingw64
-g++ -o bin\win-release\BreakoutCppWin_%version%.exe src\*.cpp third-party\src\*.c -DWINDOWS -DVERSION=\"%version%\" -Ithird-party\include -Lthird-party\lib-win -lglfw3 -lgdi32 -Wall -O2
+g++ -o bin\win-release\BreakoutCppWin_%version%.exe src\*.cpp third-party\src\*.c %embed_flags% -DWINDOWS -DVERSION=\"%version%\" -Ithird-party\include -Lthird-party\lib-win -lglfw3 -lgdi32 -std=c++17 -Wall -O2
 if %errorlevel% neq 0 exit /b %errorlevel%
 
-:: Copy shaders to bin\win-release
-robocopy assets\shaders bin\win-release\shaders > nul
+:: Compile vectorized environment library for training agents
+g++ -o bin\win-release\breakout_vecenv.dll src\vecenv.cpp src\game.cpp src\lanes.cpp src\metrics.cpp third-party\src\*.c -DWINDOWS -Ithird-party\include -shared -mavx2 -std=c++17 -Wall -O2
+if %errorlevel% neq 0 exit /b %errorlevel%
+
+:: Compile level generator (see tools\level_generator.cpp)
+g++ -o bin\win-release\level_generator.exe tools\level_generator.cpp -DWINDOWS -std=c++17 -Wall -O2
+if %errorlevel% neq 0 exit /b %errorlevel%
 
 exit 0
\ No newline at end of file
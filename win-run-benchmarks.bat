@@ -0,0 +1,27 @@
+@ECHO OFF
+
+:: Clear or create bin\benchmarks
+if exist bin\benchmarks rmdir /S /Q bin\benchmarks
+mkdir bin\benchmarks
+if %errorlevel% neq 0 exit /b %errorlevel%
+
+:: Compile benchmarks with mingw64
+g++ -o bin\benchmarks\collision_benchmark.exe benchmarks\collision_benchmark.cpp -DWINDOWS -std=c++17 -Wall -O2
+if %errorlevel% neq 0 exit /b %errorlevel%
+
+:: Run benchmarks
+bin\benchmarks\collision_benchmark.exe --json bin\benchmarks\collision.json
+if %errorlevel% neq 0 exit /b %errorlevel%
+
+:: Game benchmark, compared against the baseline in bin\benchmarks-baseline.txt when there is one
+g++ -o bin\benchmarks\game_benchmark.exe benchmarks\game_benchmark.cpp src\game.cpp src\lanes.cpp src\metrics.cpp third-party\src\*.c -DWINDOWS -Ithird-party\include -mavx2 -std=c++17 -Wall -O2
+if %errorlevel% neq 0 exit /b %errorlevel%
+
+if exist bin\benchmarks-baseline.txt (
+	bin\benchmarks\game_benchmark.exe --json bin\benchmarks\game.json --baseline bin\benchmarks-baseline.txt --threshold 10
+) else (
+	bin\benchmarks\game_benchmark.exe --json bin\benchmarks\game.json --save-baseline bin\benchmarks-baseline.txt
+)
+if %errorlevel% neq 0 exit /b %errorlevel%
+
+exit 0